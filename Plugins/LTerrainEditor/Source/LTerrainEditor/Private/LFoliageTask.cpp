@@ -1,5 +1,6 @@
 #include "LTerrainEditor.h"
 #include "LFoliageTask.h"
+#include "LRandom.h"
 
 struct Coords
 {
@@ -12,46 +13,80 @@ public:
 
 void FLFoliageTask::DoWork()
 {
-	FRandomStream stream = FRandomStream(FP.RNGSeed);
-	//get the main foliage actor for all foliage instances
-	AInstancedFoliageActor* foliageActor = AInstancedFoliageActor::GetInstancedFoliageActorForCurrentLevel(SP.terrain->GetWorld(), true);
+	LRandomStream stream = LRandomStream(SP.seed, ELRandomStage::FoliageSampling, FP.rngKey);
 
 	///START Implementation of Fast Poisson Disk Sampling in Arbitrary Dimensions - R. Bridson (2007)
-	//pick our initial point near the middle
 	TArray<FVector2D> acceptedPointLocations = TArray<FVector2D>();
 
-	//initialize our cell grid
 	int uniqueVertCountWidth = SP.landscapeComponentCountSqrt*(SP.ComponentSizeVerts - 1); //width in verts, not counting overlaps at seams
 	float realWidthcm = SP.terrain->GetActorScale().X*uniqueVertCountWidth;
-	if (FP.objectScatter->minRadius < 0.25f) FP.objectScatter->minRadius = 0.25f;
-	float minRadiuscm = FP.objectScatter->minRadius*100.f;
-	float maxRadiuscm = FP.objectScatter->maxRadius*100.f;
+	float componentWidthcm = realWidthcm / SP.landscapeComponentCountSqrt;
+	float minRadiuscm = FMath::Max(FP.minRadius, 0.25f)*100.f;
+	float maxRadiuscm = FP.maxRadius*100.f;
+
+	//only the dirty components are sampled, plus a halo of one radius
+	FVector2D boundsMin, boundsMax;
+	GetSampleBounds(SP, minRadiuscm, boundsMin, boundsMax);
+
+	//initialize our cell grid over the bounds
 	float cellSize = minRadiuscm / 1.41421f; //sqrt(n) for n-dimensional
 	float cellSizeInv = 1.f / cellSize;
-	int gridCount = (realWidthcm / cellSize) + 1; //totalTerrainSize(cm)/cellSize(cm), plus 1 padding
-	TArray<TArray<int>> grid = TArray<TArray<int>>(); //2D array of size gridCount x gridCount
-	grid.Init(TArray<int>(), gridCount);
-	for (int i = 0; i < gridCount; ++i)
+	int gridCountX = ((boundsMax.X - boundsMin.X) / cellSize) + 1; //boundsSize(cm)/cellSize(cm), plus 1 padding
+	int gridCountY = ((boundsMax.Y - boundsMin.Y) / cellSize) + 1;
+	TArray<int32> grid; //gridCountX x gridCountY, [x * gridCountY + y], pooled since it is the largest allocation of the sampler
+	SP.context->foliageGrids.Acquire(grid, gridCountX * gridCountY);
+	FMemory::Memset(grid.GetData(), 0xFF, grid.Num() * sizeof(int32)); //all -1
+
+	auto GetGridIdx = [&](const FVector2D& point)->Coords {
+		return Coords((int)((point.X - boundsMin.X)*cellSizeInv), (int)((point.Y - boundsMin.Y)*cellSizeInv));
+	};
+	auto IsTooClose = [&](const FVector2D& point, const Coords& gridIdx)->bool {
+		for (int i = -2; i <= 2; ++i)
+		{
+			for (int j = -2; j <= 2; ++j)
+			{
+				if (gridIdx.x + i < 0 || gridIdx.x + i >= gridCountX ||
+					gridIdx.y + j < 0 || gridIdx.y + j >= gridCountY)
+					continue;
+
+				int32 neighborIdx = grid[(gridIdx.x + i) * gridCountY + gridIdx.y + j];
+				if (neighborIdx >= 0 && FVector2D::Distance(point, acceptedPointLocations[neighborIdx]) < minRadiuscm)
+					return true;
+			}
+		}
+		return false;
+	};
+
+	//generated instances kept just outside the dirty components go in the grid first, so new points keep their distance
+	//from them, they are never active and are dropped with the rest of the halo below
+	for (const FVector2D& kept : FP.keptPoints)
 	{
-		grid[i].Init(-1, gridCount);
+		Coords keptGridIdx = GetGridIdx(kept);
+		if (grid[keptGridIdx.x * gridCountY + keptGridIdx.y] >= 0) continue; //closer than a cell to another kept instance
+		grid[keptGridIdx.x * gridCountY + keptGridIdx.y] = acceptedPointLocations.Add(kept);
 	}
 
-	//create and insert the initial point
+	//create and insert the initial point near the middle of the bounds
 	//active list points to grid list, grid list points to accepted list
 	TArray<Coords> activePoints = TArray<Coords>();
-	acceptedPointLocations.Add(FVector2D(
-		stream.FRandRange(realWidthcm*0.25f, realWidthcm*0.75f),
-		stream.FRandRange(realWidthcm*0.25f, realWidthcm*0.75f)));
-	Coords i0gridIdx = Coords((int)(acceptedPointLocations[0].X*cellSizeInv), (int)(acceptedPointLocations[0].Y*cellSizeInv));
-	grid[i0gridIdx.x][i0gridIdx.y] = 0; //point to initial point
-	activePoints.Add(i0gridIdx);
-
-	while (activePoints.Num() > 0)
+	for (int attempt = 0; attempt < 30 && activePoints.Num() == 0; ++attempt)
+	{
+		FVector2D initialPoint = FVector2D(
+			stream.FRandRange(FMath::Lerp(boundsMin.X, boundsMax.X, 0.25f), FMath::Lerp(boundsMin.X, boundsMax.X, 0.75f)),
+			stream.FRandRange(FMath::Lerp(boundsMin.Y, boundsMax.Y, 0.25f), FMath::Lerp(boundsMin.Y, boundsMax.Y, 0.75f)));
+		Coords i0gridIdx = GetGridIdx(initialPoint);
+		if (IsTooClose(initialPoint, i0gridIdx)) continue;
+
+		grid[i0gridIdx.x * gridCountY + i0gridIdx.y] = acceptedPointLocations.Add(initialPoint); //point to initial point
+		activePoints.Add(i0gridIdx);
+	}
+
+	while (activePoints.Num() > 0 && !SP.bCancelled)
 	{
 		//pick random active point
 		int randActivePointIdx = stream.RandRange(0, activePoints.Num() - 1);
-		FVector2D activePoint = acceptedPointLocations[grid
-			[activePoints[randActivePointIdx].x][activePoints[randActivePointIdx].y]];
+		const Coords& activeGridIdx = activePoints[randActivePointIdx];
+		FVector2D activePoint = acceptedPointLocations[grid[activeGridIdx.x * gridCountY + activeGridIdx.y]];
 		FVector2D candidate;
 		float radDist;
 		bool candidateFound = false;
@@ -62,48 +97,29 @@ void FLFoliageTask::DoWork()
 			candidate = activePoint + FVector2D(radDist, 0.f).GetRotated(stream.FRandRange(0.f, 359.99f));
 
 			// if we're out of bounds, throw candidate out
-			if (candidate.X < 0.f || candidate.X >= realWidthcm || candidate.Y < 0.f || candidate.Y >= realWidthcm)
+			if (candidate.X < boundsMin.X || candidate.X >= boundsMax.X || candidate.Y < boundsMin.Y || candidate.Y >= boundsMax.Y)
 				continue;
 
-			canGridIdx = Coords((int)(candidate.X*cellSizeInv), (int)(candidate.Y*cellSizeInv));
+			canGridIdx = GetGridIdx(candidate);
 
-			if (grid[canGridIdx.x][canGridIdx.y] >= 0)
+			if (grid[canGridIdx.x * gridCountY + canGridIdx.y] >= 0)
 			{
 				continue; //if this grid spot is occupied, it's too close, throw candidate out
 			}
 
-			//check neighbor of 8 cells
-			candidateFound = true; //mark true until failure found
-			for (int i = -2; i <= 2; ++i)
+			//check neighbors within 2 cells
+			if (!IsTooClose(candidate, canGridIdx))
 			{
-				for (int j = -2; j <= 2; ++j)
-				{
-					if (i == j && i == 0)
-						continue;
-					if (canGridIdx.x + i < 0 || canGridIdx.x + i >= gridCount ||
-						canGridIdx.y + j < 0 || canGridIdx.y + j >= gridCount)
-						continue;
-
-					if (grid[canGridIdx.x + i][canGridIdx.y + j] >= 0) //if neighbor point found
-					{
-						float neighborDist = FVector2D::Distance(candidate, acceptedPointLocations[grid[canGridIdx.x + i][canGridIdx.y + j]]);
-						if (neighborDist < minRadiuscm)
-						{
-							candidateFound = false;
-							goto exitloop;
-						}
-					}
-				}
+				candidateFound = true;
+				break;
 			}
-			if (candidateFound) break;
-		exitloop:;
 		}
 
 		//valid point, add to accepted list and active point list
 		if (candidateFound)
 		{
 			int addedIdx = acceptedPointLocations.Add(candidate);
-			grid[canGridIdx.x][canGridIdx.y] = addedIdx;
+			grid[canGridIdx.x * gridCountY + canGridIdx.y] = addedIdx;
 			activePoints.Add(canGridIdx);
 		}
 		else //failed to find new acceptable point, remove from active list
@@ -112,31 +128,68 @@ void FLFoliageTask::DoWork()
 		}
 	}
 	///END Implementation of Fast Poisson Disk Sampling in Arbitrary Dimensions - R. Bridson (2007)
+	SP.context->foliageGrids.Release(grid);
+
+	//bucket points by component, so each component can be trimmed as soon as its data exists
+	//points in the halo, in components kept from the last generation, are dropped here, kept instances among them
+	FP.componentPoints.Init(TArray<FVector2D>(), SP.landscapeComponentCount);
+	for (const FVector2D& point : acceptedPointLocations)
+	{
+		int compIdx = FMath::FloorToInt(point.Y / componentWidthcm) * SP.landscapeComponentCountSqrt + FMath::FloorToInt(point.X / componentWidthcm);
+		if (!SP.dirtyComponents[compIdx]) continue;
+		FP.componentPoints[compIdx].Add(point);
+	}
+	onCompletion.ExecuteIfBound(!SP.bCancelled); //succeeded in process unless cancelled part way
+}
+
+void FLFoliageTask::GetSampleBounds(const LSharedTaskParams& SP, float minRadiuscm, FVector2D& outMin, FVector2D& outMax)
+{
+	float realWidthcm = SP.terrain->GetActorScale().X * SP.landscapeComponentCountSqrt * (SP.ComponentSizeVerts - 1);
+	float componentWidthcm = realWidthcm / SP.landscapeComponentCountSqrt;
+
+	FIntRect dirtyBounds = FIntRect(SP.landscapeComponentCountSqrt, SP.landscapeComponentCountSqrt, 0, 0);
+	for (TConstSetBitIterator<> it(SP.dirtyComponents); it; ++it)
+	{
+		dirtyBounds.Include(FIntPoint(it.GetIndex() % SP.landscapeComponentCountSqrt, it.GetIndex() / SP.landscapeComponentCountSqrt));
+	}
+	outMin = FVector2D(
+		FMath::Max(dirtyBounds.Min.X * componentWidthcm - minRadiuscm, 0.f),
+		FMath::Max(dirtyBounds.Min.Y * componentWidthcm - minRadiuscm, 0.f));
+	outMax = FVector2D(
+		FMath::Min((dirtyBounds.Max.X + 1) * componentWidthcm + minRadiuscm, realWidthcm),
+		FMath::Min((dirtyBounds.Max.Y + 1) * componentWidthcm + minRadiuscm, realWidthcm));
+}
+
+void FLFoliageTask::TrimComponent(const LSharedTaskParams& SP, const LFoliageParams& FP, int32 compIdx, TArray<FVector>& outLocations3D)
+{
+	const TArray<FVector2D>& points = FP.componentPoints[compIdx];
+	if (points.Num() == 0) return;
 
-	//trim accepted points based on blend map and obtain Z coordinate
-	FP.acceptedLocations3D = TArray<FVector>();
+	//keyed per component so the result does not depend on the order components finish in
+	LRandomStream stream = LRandomStream(SP.seed, ELRandomStage::FoliageTrim, FP.rngKey, compIdx);
+	float componentWidthcm = SP.terrain->GetActorScale().X * (SP.ComponentSizeVerts - 1);
 	float U16ToMeters = 1.f / SP.metersToU16;
-	for (int i = 0; i < acceptedPointLocations.Num(); ++i)
+	for (const FVector2D& point : points)
 	{
-		const FVector2D& point = acceptedPointLocations[i];
-		int patchIdx = SP.lSystem->patches.Find(FP.patch);
 		//blend data coords as XX.YY, where XX is the landscape component, YY is cordinates within component
-		float coordX = (point.X / (realWidthcm / SP.landscapeComponentCountSqrt));
-		float coordY = (point.Y / (realWidthcm / SP.landscapeComponentCountSqrt));
-		int compIdx = FMath::FloorToInt(coordY) * SP.landscapeComponentCountSqrt + FMath::FloorToInt(coordX); //landscape component
+		float coordX = point.X / componentWidthcm;
+		float coordY = point.Y / componentWidthcm;
 		int subIdx = FMath::FloorToInt(FMath::Frac(coordY) * SP.ComponentSizeVerts) * SP.ComponentSizeVerts + FMath::FloorToInt(FMath::Frac(coordX) * SP.ComponentSizeVerts);//idx inside landscape component
-		bool removeInstance = false;
-		float blendVal = SP.patchBlendData[compIdx][patchIdx][subIdx];
+		float blendVal = (SP.bStreaming) ?
+			SP.retainedComponents[compIdx].GetWeight(FP.patchIdx, subIdx) :
+			SP.patchBlendData[compIdx][subIdx].GetWeight(FP.patchIdx);
 
 		//use RNG to toss out some % of instances based on blendVal linearly from 1.0 to 0.5
 		if (blendVal < 0.5f) continue;
 		else if (blendVal < 0.95f && (stream.GetFraction() / 2.f) + 0.5f > blendVal) continue;
 		else
 		{
-			int sIntHeight = ((int)SP.heightMaps[compIdx][subIdx].R << 8) | ((int)SP.heightMaps[compIdx][subIdx].G);
-			float terrainZ = (float)(sIntHeight - SP.zeroHeight) * U16ToMeters * 100.f; //to cm
-			FP.acceptedLocations3D.Add(FVector(point, terrainZ));
+			//streaming only kept a downsampled copy of the heights, which is interpolated at the point itself
+			float sIntHeight = (SP.bStreaming) ?
+				SP.retainedComponents[compIdx].GetHeight(FMath::Frac(coordX) * (SP.ComponentSizeVerts - 1), FMath::Frac(coordY) * (SP.ComponentSizeVerts - 1)) :
+				(float)SP.heightMaps[compIdx][subIdx];
+			float terrainZ = (sIntHeight - SP.zeroHeight) * U16ToMeters * 100.f; //to cm
+			outLocations3D.Add(FVector(point, terrainZ));
 		}
 	}
-	onCompletion.ExecuteIfBound(true); //succeeded in process
 }
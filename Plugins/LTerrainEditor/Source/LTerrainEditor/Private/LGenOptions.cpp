@@ -1,19 +1,51 @@
 #include "LTerrainEditor.h"
 #include "LGenOptions.h"
 #include "LTerrainGeneration.h"
+#include "LGenerationQueue.h"
+#include "LVariantPreviewJob.h"
 #include "Kismet/GameplayStatics.h"
 #include "Editor.h"
+#include "Engine/Selection.h"
 #include "LandscapeLayerInfoObject.h"
 #include "FoliageType.h"
 #include "Dialogs/DlgPickAssetPath.h"
 #include "AssetRegistryModule.h"
 #include "FoliageType_InstancedStaticMesh.h"
+#include "Rendering/SlateRenderer.h"
 
 #define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
 
+//one radio style check box of the height interpolation row
+static TSharedRef<SWidget> MakeHeightInterpolationOption(TSharedPtr<FLTerrainEditorModule> lTerrainModule, ELHeightInterpolation interpolation, const FText& label)
+{
+	return SNew(SHorizontalBox)
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.Padding(2)
+		[
+			SNew(SCheckBox)
+			.Style(FCoreStyle::Get(), "RadioButton")
+			.IsChecked_Lambda([lTerrainModule, interpolation]()->ECheckBoxState {
+				return (lTerrainModule->lSystem.genSettings.heightInterpolation == interpolation) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+			})
+			.OnCheckStateChanged_Lambda([lTerrainModule, interpolation](ECheckBoxState checkstate) {
+				if (checkstate == ECheckBoxState::Checked)
+					lTerrainModule->lSystem.genSettings.heightInterpolation = interpolation;
+			})
+		]
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.Padding(2)
+		[
+			SNew(STextBlock)
+			.Text(label)
+		];
+}
+
 void SLGenOptions::Construct(const FArguments & args)
 {
 	lTerrainModule = FLTerrainEditorModule::GetModule();
+	variantImageCount = 0;
 
 	ChildSlot
 	[
@@ -112,9 +144,472 @@ void SLGenOptions::Construct(const FArguments & args)
 			+ SVerticalBox::Slot()
 			.AutoHeight()
 			[
-				SNew(SButton)
-				.Text(LOCTEXT("GenTerrainButton", "+ Generate Terrain"))
-				.OnClicked_Raw(this, &SLGenOptions::OnGenerateClicked)
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("SmoothRadius", "Smoothing Radius:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(60.f)
+					.MinValue(0)
+					.MaxValue(64)
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.smoothRadius;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.smoothRadius = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("SmoothIterations", " Iterations:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(60.f)
+					.MinValue(0)
+					.MaxValue(16)
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.smoothIterations;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.smoothIterations = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("SmoothGaussian", " Gaussian"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SCheckBox)
+					.IsChecked_Lambda([this]()->ECheckBoxState {
+						return (lTerrainModule->lSystem.genSettings.bSmoothGaussian) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+					})
+					.OnCheckStateChanged_Lambda([this](ECheckBoxState checkstate) {
+						lTerrainModule->lSystem.genSettings.bSmoothGaussian = (checkstate == ECheckBoxState::Checked);
+					})
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("HeightInterpolation", "Height Interpolation:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				[
+					MakeHeightInterpolationOption(lTerrainModule, ELHeightInterpolation::Linear, LOCTEXT("HeightInterpolationLinear", "Linear"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				[
+					MakeHeightInterpolationOption(lTerrainModule, ELHeightInterpolation::EasedLinear, LOCTEXT("HeightInterpolationEased", "Eased"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				[
+					MakeHeightInterpolationOption(lTerrainModule, ELHeightInterpolation::CatmullRom, LOCTEXT("HeightInterpolationCatmullRom", "Catmull-Rom"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				[
+					MakeHeightInterpolationOption(lTerrainModule, ELHeightInterpolation::BSpline, LOCTEXT("HeightInterpolationBSpline", "B-Spline"))
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenSeed", "Seed:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(100.f)
+					.MinValue(0)
+					.MaxValue(INT32_MAX)
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.seed;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.seed = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenIncremental", " Only Regenerate Changed Components"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SCheckBox)
+					.IsChecked_Lambda([this]()->ECheckBoxState {
+						return (lTerrainModule->lSystem.genSettings.bIncremental) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+					})
+					.OnCheckStateChanged_Lambda([this](ECheckBoxState checkstate) {
+						lTerrainModule->lSystem.genSettings.bIncremental = (checkstate == ECheckBoxState::Checked);
+					})
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SCheckBox)
+					.IsChecked_Lambda([this]()->ECheckBoxState {
+						return (lTerrainModule->lSystem.genSettings.bUseRegion) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+					})
+					.OnCheckStateChanged_Lambda([this](ECheckBoxState checkstate) {
+						lTerrainModule->lSystem.genSettings.bUseRegion = (checkstate == ECheckBoxState::Checked);
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegion", "Only Regenerate Components From"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegionMinX", " X:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(256)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bUseRegion;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.region.Min.X;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.region.Min.X = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegionMinY", " Y:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(256)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bUseRegion;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.region.Min.Y;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.region.Min.Y = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegionMaxX", " To (Exclusive) X:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(256)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bUseRegion;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.region.Max.X;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.region.Max.X = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegionMaxY", " Y:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(256)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bUseRegion;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.region.Max.Y;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.region.Max.Y = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GenRegionFeather", " Border Feather:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(1024)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bUseRegion;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.regionBorderFeather;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.regionBorderFeather = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SButton)
+					.Text(LOCTEXT("GenRegionFromSelection", "Use Selection"))
+					.OnClicked_Raw(this, &SLGenOptions::OnRegionFromSelectionClicked)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SButton)
+					.Text(LOCTEXT("GenTerrainButton", "+ Generate Terrain"))
+					.OnClicked_Raw(this, &SLGenOptions::OnGenerateClicked)
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SButton)
+					.Text(LOCTEXT("CancelGenButton", "Cancel All"))
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->generationQueue->IsBusy();
+					})
+					.OnClicked_Raw(this, &SLGenOptions::OnCancelGenerateClicked)
+				]
+				+ SHorizontalBox::Slot()
+				.FillWidth(1)
+				.VAlign(VAlign_Center)
+				.Padding(2)
+				[
+					SNew(SProgressBar)
+					.Percent_Lambda([this]()->TOptional<float> {
+						LQueuedJobPtr job = lTerrainModule->generationQueue->GetStatusJob();
+						if (!job.IsValid()) return 0.f;
+						return job->GetProgress();
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("WorkerThreads", "Worker Threads (0 = auto):"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(0)
+					.MaxValue(64)
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.workerThreadCount;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.workerThreadCount = val;
+						lTerrainModule->generationQueue->SetPoolSize(val);
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("Streaming", " Streaming"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SCheckBox)
+					.IsChecked_Lambda([this]()->ECheckBoxState {
+						return (lTerrainModule->lSystem.genSettings.bStreaming) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+					})
+					.OnCheckStateChanged_Lambda([this](ECheckBoxState checkstate) {
+						lTerrainModule->lSystem.genSettings.bStreaming = (checkstate == ECheckBoxState::Checked);
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("StreamingBudget", " Budget (MB):"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(60.f)
+					.MinValue(64)
+					.MaxValue(65536)
+					.IsEnabled_Lambda([this]()->bool {
+						return lTerrainModule->lSystem.genSettings.bStreaming;
+					})
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.streamingBudgetMB;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.streamingBudgetMB = val;
+					})
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.VAlign(VAlign_Center)
+				.Padding(2)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("VariantCount", "Variants:"))
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SSpinBox<int>)
+					.MinDesiredWidth(50.f)
+					.MinValue(1)
+					.MaxValue(16)
+					.Value_Lambda([this]()->int {
+						return lTerrainModule->lSystem.genSettings.variantCount;
+					})
+					.OnValueChanged_Lambda([this](int val) {
+						lTerrainModule->lSystem.genSettings.variantCount = val;
+					})
+				]
+				+ SHorizontalBox::Slot()
+				.AutoWidth()
+				.Padding(2)
+				[
+					SNew(SButton)
+					.Text(LOCTEXT("PreviewVariantsButton", "Preview Variants"))
+					.ToolTipText(LOCTEXT("PreviewVariantsTooltip", "Previews the heightmap for the seeds starting at Seed, click a preview to generate it"))
+					.OnClicked_Raw(this, &SLGenOptions::OnPreviewVariantsClicked)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SScrollBox)
+				.Orientation(Orient_Horizontal)
+				+ SScrollBox::Slot()
+				[
+					SAssignNew(variantBox, SHorizontalBox)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(2)
+			[
+				SNew(STextBlock)
+				.Text_Lambda([this]()->FText {
+					LQueuedJobPtr job = lTerrainModule->generationQueue->GetStatusJob();
+					if (!job.IsValid()) return FText::GetEmpty();
+
+					int32 pendingCount = lTerrainModule->generationQueue->GetPendingCount();
+					if (pendingCount == 0) return job->GetStatusText();
+					return FText::Format(LOCTEXT("GenStatusQueued", "{0} ({1} queued)"), job->GetStatusText(), FText::AsNumber(pendingCount));
+				})
 			]
 		]
 	];
@@ -163,8 +658,141 @@ FReply SLGenOptions::OnGenerateClicked()
 	ALandscape* landscape = (actors.Num() > 0)? Cast<ALandscape>(actors[0]) : nullptr;
 	if (lTerrainModule->lSystem.lSystemLoDs.Num() > 0 && landscape != nullptr)
 	{
-		LTerrainGeneration::GenerateTerrain(lTerrainModule->lSystem, landscape);
+		LGenSettings& settings = lTerrainModule->lSystem.genSettings;
+		if (settings.bUseRegion)
+		{
+			//the spin boxes do not know the landscape's size, clamped here so they show the region actually generated
+			int32 countSqrt = FMath::Sqrt(landscape->LandscapeComponents.Num());
+			settings.region.Clip(FIntRect(0, 0, countSqrt, countSqrt));
+		}
+		LTerrainGeneration::GenerateTerrain(lTerrainModule->lSystem, landscape, *lTerrainModule->generationCache,
+			(settings.bUseRegion) ? &settings.region : nullptr);
+	}
+	return FReply::Handled();
+}
+
+//queues previews of the next variantCount seeds from the current one on the first landscape
+FReply SLGenOptions::OnPreviewVariantsClicked()
+{
+	TArray<AActor*> actors;
+	UWorld* world = GEditor->GetEditorWorldContext().World();
+	UGameplayStatics::GetAllActorsOfClass(world, ALandscape::StaticClass(), actors);
+	ALandscape* landscape = (actors.Num() > 0) ? Cast<ALandscape>(actors[0]) : nullptr;
+	if (lTerrainModule->lSystem.lSystemLoDs.Num() == 0 || landscape == nullptr) return FReply::Handled();
+
+	const LGenSettings& settings = lTerrainModule->lSystem.genSettings;
+	TArray<int32> seeds;
+	for (int32 i = 0; i < FMath::Max(settings.variantCount, 1); ++i)
+	{
+		seeds.Add(settings.seed + i);
+	}
+
+	TWeakPtr<SLGenOptions> weakThis = SharedThis(this);
+	lTerrainModule->generationQueue->Enqueue(MakeShareable(new LVariantPreviewJob(lTerrainModule->lSystem, landscape, seeds, FOnVariantsPreviewed::CreateLambda([weakThis](const TArray<LVariantPreview>& previews) {
+		TSharedPtr<SLGenOptions> genOptions = weakThis.Pin();
+		if (genOptions.IsValid()) genOptions->ShowVariantPreviews(previews);
+	}))));
+
+	return FReply::Handled();
+}
+
+//generates the chosen variant for real
+FReply SLGenOptions::OnApplyVariantClicked(int32 seed)
+{
+	lTerrainModule->lSystem.genSettings.seed = seed;
+	return OnGenerateClicked();
+}
+
+//one grayscale image per variant, all on the same height range so they can be compared
+void SLGenOptions::ShowVariantPreviews(const TArray<LVariantPreview>& previews)
+{
+	variantBox->ClearChildren();
+	variantBrushes.Reset();
+
+	uint16 minHeight = UINT16_MAX;
+	uint16 maxHeight = 0;
+	for (const LVariantPreview& preview : previews)
+	{
+		minHeight = FMath::Min(minHeight, preview.minHeight);
+		maxHeight = FMath::Max(maxHeight, preview.maxHeight);
 	}
+	const float heightScale = 255.f / FMath::Max((int32)maxHeight - (int32)minHeight, 1);
+
+	for (const LVariantPreview& preview : previews)
+	{
+		//BGRA
+		TArray<uint8> bytes;
+		bytes.SetNumUninitialized(preview.heights.Num() * 4);
+		for (int32 pixelIdx = 0; pixelIdx < preview.heights.Num(); ++pixelIdx)
+		{
+			uint8 value = (uint8)FMath::Clamp(FMath::RoundToInt((preview.heights[pixelIdx] - minHeight) * heightScale), 0, 255);
+			bytes[pixelIdx * 4 + 0] = value;
+			bytes[pixelIdx * 4 + 1] = value;
+			bytes[pixelIdx * 4 + 2] = value;
+			bytes[pixelIdx * 4 + 3] = 255;
+		}
+
+		FName imageName = FName(*FString::Printf(TEXT("LTerrainVariantPreview_%d"), variantImageCount++));
+		if (!FSlateApplication::Get().GetRenderer()->GenerateDynamicImageResource(imageName, preview.size, preview.size, bytes)) continue;
+
+		TSharedPtr<FSlateDynamicImageBrush> brush = MakeShareable(new FSlateDynamicImageBrush(imageName, FVector2D(preview.size, preview.size)));
+		variantBrushes.Add(brush);
+
+		const int32 seed = preview.seed;
+		variantBox->AddSlot()
+		.AutoWidth()
+		.Padding(2)
+		[
+			SNew(SVerticalBox)
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			[
+				SNew(SButton)
+				.ToolTipText(LOCTEXT("ApplyVariantTooltip", "Generate the landscape with this seed"))
+				.OnClicked_Raw(this, &SLGenOptions::OnApplyVariantClicked, seed)
+				[
+					SNew(SImage)
+					.Image(brush.Get())
+				]
+			]
+			+ SVerticalBox::Slot()
+			.AutoHeight()
+			.HAlign(HAlign_Center)
+			[
+				SNew(STextBlock)
+				.Text(FText::Format(LOCTEXT("VariantSeed", "Seed {0}"), FText::AsNumber(seed)))
+			]
+		];
+	}
+}
+
+FReply SLGenOptions::OnCancelGenerateClicked()
+{
+	lTerrainModule->generationQueue->CancelAll();
+	return FReply::Handled();
+}
+
+//sets the generation region to the components under the bounds of the selected actors
+FReply SLGenOptions::OnRegionFromSelectionClicked()
+{
+	TArray<AActor*> actors;
+	UWorld* world = GEditor->GetEditorWorldContext().World();
+	UGameplayStatics::GetAllActorsOfClass(world, ALandscape::StaticClass(), actors);
+	ALandscape* landscape = (actors.Num() > 0) ? Cast<ALandscape>(actors[0]) : nullptr;
+	if (landscape == nullptr) return FReply::Handled();
+
+	FBox selectionBounds = FBox(ForceInit);
+	for (FSelectionIterator it(GEditor->GetSelectedActorIterator()); it; ++it)
+	{
+		AActor* actor = Cast<AActor>(*it);
+		if (actor == nullptr || actor == landscape) continue;
+		selectionBounds += actor->GetComponentsBoundingBox(true);
+	}
+	if (!selectionBounds.IsValid) return FReply::Handled();
+
+	LGenSettings& settings = lTerrainModule->lSystem.genSettings;
+	settings.region = LTerrainGeneration::GetComponentRegionFromWorldBox(landscape, selectionBounds);
+	settings.bUseRegion = true;
 	return FReply::Handled();
 }
 
@@ -0,0 +1,204 @@
+#include "LTerrainEditor.h"
+#include "LGenerationBenchmark.h"
+#include "LTerrainComponentMainTask.h"
+
+void LGenerationBenchmark::BuildSyntheticLSystem(LSystem& lSystem, const LGenerationBenchmarkParams& params)
+{
+	FRandomStream stream = FRandomStream(params.seed);
+
+	lSystem.symbols = TArray<LSymbolPtr>();
+	lSystem.patches = TArray<LPatchPtr>();
+	lSystem.groundTextures = TArray<LGroundTexturePtr>();
+	lSystem.lSystemLoDs = TArray<LSymbol2DMapPtr>();
+
+	for (int i = 0; i < FMath::Max(params.layerCount, 0); ++i)
+	{
+		LGroundTexturePtr groundTexture = LGroundTexturePtr(new LGroundTexture());
+		groundTexture->name = FString::Printf(TEXT("Bench Layer %d"), i);
+		lSystem.groundTextures.Add(groundTexture);
+	}
+
+	int patchCount = FMath::Max(params.patchCount, 1);
+	for (int i = 0; i < patchCount; ++i)
+	{
+		LSymbolPtr symbol = LSymbolPtr(new LSymbol('a' + (i % 26), FString::Printf(TEXT("Bench %d"), i)));
+		lSystem.symbols.Add(symbol);
+
+		LPatchPtr patch = LPatchPtr(new LPatch());
+		patch->name = FString::Printf(TEXT("Bench Patch %d"), i);
+		patch->matchVal = symbol;
+		patch->minHeight = stream.FRandRange(-20.f, 0.f);
+		patch->maxHeight = stream.FRandRange(0.f, 40.f);
+
+		for (int n = 0; n < params.noiseMapsPerPatch; ++n)
+		{
+			LNoisePtr noise = LNoisePtr(new LNoise(ENoiseType::PERLIN, stream.RandHelper(INT_MAX)));
+			noise->frequency = stream.FRandRange(0.05f, 1.f);
+			noise->amplitude = stream.FRandRange(1.f, 10.f);
+			patch->noiseMaps.Add(noise);
+		}
+
+		//every other layer is broken up by noise, so both weightmap paths are exercised
+		for (int layerIdx = 0; layerIdx < lSystem.groundTextures.Num(); ++layerIdx)
+		{
+			LPaintWeightPtr paintWeight = LPaintWeightPtr(new LPaintWeight());
+			paintWeight->texture = lSystem.groundTextures[layerIdx];
+			paintWeight->weight = stream.FRandRange(0.25f, 1.f);
+			if (layerIdx % 2 == 1)
+			{
+				paintWeight->noiseMap = LNoisePtr(new LNoise(ENoiseType::PERLIN, stream.RandHelper(INT_MAX)));
+				paintWeight->noiseMap->frequency = 0.5f;
+				paintWeight->noiseMap->amplitude = 2.f;
+			}
+			patch->paintWeights.Add(paintWeight);
+		}
+
+		lSystem.patches.Add(patch);
+	}
+
+	int sourceSize = FMath::Max(params.componentCountSqrt * params.cellsPerComponent, 1);
+	LSymbol2DMapPtr sourceMap = LSymbol::CreateLSymbolMap(sourceSize, sourceSize);
+	for (int i = 0; i < sourceSize; ++i)
+	{
+		for (int j = 0; j < sourceSize; ++j)
+		{
+			(*sourceMap)[i][j] = lSystem.symbols[stream.RandRange(0, patchCount - 1)];
+		}
+	}
+	lSystem.lSystemLoDs.Add(sourceMap);
+}
+
+//the parts of PrepareGeneration the component kernel reads, with every component dirty and allocated
+void LGenerationBenchmark::BuildSharedParams(LSharedTaskParams& SP, LSystem& lSystem, const LGenerationBenchmarkParams& params)
+{
+	SP.terrain = nullptr;
+	SP.lSystem = &lSystem;
+	SP.seed = params.seed;
+	SP.landscapeComponentCountSqrt = FMath::Max(params.componentCountSqrt, 1);
+	SP.landscapeComponentCount = FMath::Square(SP.landscapeComponentCountSqrt);
+	SP.ComponentSizeVerts = params.numSubsections * (params.subsectionSizeQuads + 1);
+	SP.sourceLSymbolMap = lSystem.lSystemLoDs[lSystem.lSystemLoDs.Num() - 1];
+	SP.sourceSizeX = (*SP.sourceLSymbolMap)[0].Num();
+	SP.sourceSizeY = (*SP.sourceLSymbolMap).Num();
+	SP.layerCount = lSystem.groundTextures.Num();
+	SP.metersToU16 = (UINT16_MAX / 2) / 256.f;
+	SP.zeroHeight = UINT16_MAX / 2;
+
+	LTerrainGeneration::BuildPatchTables(SP);
+
+	LTerrainGeneration::BuildRoughHeightmap(SP, SP.seed, SP.roughHeightmap);
+	LTerrainGeneration::SmoothHeightmap(SP, lSystem.genSettings, SP.roughHeightmap, SP.smoothedHeightMap);
+	LTerrainGeneration::BuildSamplingPlan(SP);
+
+	const int32 vertCount = FMath::Square(SP.ComponentSizeVerts);
+	SP.heightMaps.Init(TArray<uint16>(), SP.landscapeComponentCount);
+	SP.patchBlendData.Init(TArray<LPatchBlend>(), SP.landscapeComponentCount);
+	SP.weightMaps.Init(TArray<TArray<uint8>>(), SP.landscapeComponentCount);
+	for (int32 compIdx = 0; compIdx < SP.landscapeComponentCount; ++compIdx)
+	{
+		SP.heightMaps[compIdx].SetNumZeroed(vertCount);
+		SP.patchBlendData[compIdx].SetNumZeroed(vertCount);
+		SP.weightMaps[compIdx].Init(TArray<uint8>(), SP.layerCount);
+		for (TArray<uint8>& layerWeights : SP.weightMaps[compIdx])
+		{
+			layerWeights.SetNumZeroed(vertCount);
+		}
+	}
+	SP.bCancelled = false;
+	SP.tileKernel = FLTerrainComponentMainTask::SelectTileKernel(SP);
+}
+
+//every component in units of unitSize vertices, row major within each component
+LGenerationBenchmarkResult LGenerationBenchmark::Run(LSharedTaskParams& SP, const FString& traversal, FIntPoint unitSize)
+{
+	LWeightRowScratch weightScratch;
+	weightScratch.Init(unitSize.X, SP.layerCount);
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 compIdx = 0; compIdx < SP.landscapeComponentCount; ++compIdx)
+	{
+		for (int32 y = 0; y < SP.ComponentSizeVerts; y += unitSize.Y)
+		{
+			for (int32 x = 0; x < SP.ComponentSizeVerts; x += unitSize.X)
+			{
+				FIntRect unit = FIntRect(x, y, FMath::Min(x + unitSize.X, SP.ComponentSizeVerts), FMath::Min(y + unitSize.Y, SP.ComponentSizeVerts));
+				SP.tileKernel(SP, LTerrainGeneration::GetGlobalVerts(SP, compIdx, unit), FLTerrainComponentMainTask::GetComponentTarget(SP, compIdx, unit), weightScratch);
+			}
+		}
+	}
+	double endTime = FPlatformTime::Seconds();
+
+	LGenerationBenchmarkResult result;
+	result.traversal = traversal;
+	result.unitSize = unitSize;
+	result.seconds = endTime - startTime;
+	result.vertsPerSecond = (result.seconds > 0.0) ? (double)SP.landscapeComponentCount * FMath::Square(SP.ComponentSizeVerts) / result.seconds : 0.0;
+	result.unitOutputBytes = (SIZE_T)unitSize.X * unitSize.Y * (sizeof(uint16) + sizeof(LPatchBlend) + SP.layerCount);
+	return result;
+}
+
+void LGenerationBenchmark::RunAndLog(const LGenerationBenchmarkParams& params)
+{
+	LSystem lSystem;
+	BuildSyntheticLSystem(lSystem, params);
+	LGenerationContext context;
+	LSharedTaskParams SP;
+	SP.context = &context;
+	BuildSharedParams(SP, lSystem, params);
+
+	UE_LOG(LogLTerrain, Display, TEXT("Generation benchmark: %dx%d components of %d verts, %d patches, %d layers, %dx%d source map"),
+		SP.landscapeComponentCountSqrt, SP.landscapeComponentCountSqrt, SP.ComponentSizeVerts, SP.patches.Num(), SP.layerCount, SP.sourceSizeX, SP.sourceSizeY);
+
+	const int32 width = SP.ComponentSizeVerts;
+	TArray<LGenerationBenchmarkResult> results = TArray<LGenerationBenchmarkResult>();
+
+	//first pass only warms the caches and the allocator
+	Run(SP, TEXT("warmup"), FIntPoint(width, width));
+
+	//full width bands the size the scheduler used before tiling
+	results.Add(Run(SP, TEXT("row band"), FIntPoint(width, FMath::Clamp(2048 / width, 1, width))));
+	const int32 tileSizes[] = { 64, 32, 16 };
+	for (int32 tileSize : tileSizes)
+	{
+		if (tileSize > width) continue;
+		results.Add(Run(SP, TEXT("tile"), FIntPoint(tileSize, tileSize)));
+	}
+
+	//the other height interpolation policies on the tile size generation uses
+	const int32 tileSize = FMath::Min(LTerrainGeneration::DefaultTileVerts, width);
+	const ELHeightInterpolation interpolations[] = { ELHeightInterpolation::Linear, ELHeightInterpolation::CatmullRom, ELHeightInterpolation::BSpline };
+	const TCHAR* interpolationNames[] = { TEXT("linear tile"), TEXT("catmull-rom tile"), TEXT("b-spline tile") };
+	for (int32 i = 0; i < ARRAY_COUNT(interpolations); ++i)
+	{
+		lSystem.genSettings.heightInterpolation = interpolations[i];
+		LTerrainGeneration::BuildSamplingPlan(SP);
+		results.Add(Run(SP, interpolationNames[i], FIntPoint(tileSize, tileSize)));
+	}
+
+	const double baseline = results[0].vertsPerSecond;
+	for (const LGenerationBenchmarkResult& result : results)
+	{
+		UE_LOG(LogLTerrain, Display, TEXT("  %s %dx%d: %.3f ms, %.2f Mverts/sec (%.2fx), %.1f KB written per unit"),
+			*result.traversal,
+			result.unitSize.X,
+			result.unitSize.Y,
+			result.seconds * 1000.0,
+			result.vertsPerSecond / 1.e6,
+			(baseline > 0.0) ? result.vertsPerSecond / baseline : 0.0,
+			result.unitOutputBytes / 1024.0);
+	}
+}
+
+static void BenchmarkGenerationCommand(const TArray<FString>& args)
+{
+	LGenerationBenchmarkParams params = LGenerationBenchmarkParams();
+	if (args.Num() > 0) params.componentCountSqrt = FCString::Atoi(*args[0]);
+	if (args.Num() > 1) params.patchCount = FCString::Atoi(*args[1]);
+	if (args.Num() > 2) params.layerCount = FCString::Atoi(*args[2]);
+	LGenerationBenchmark::RunAndLog(params);
+}
+
+static FAutoConsoleCommand BenchmarkGenerationCmd(
+	TEXT("LTerrain.BenchmarkGeneration"),
+	TEXT("Times component generation with row band and tiled traversal on a synthetic landscape. Args: [componentCountSqrt] [patches] [layers]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkGenerationCommand));
@@ -0,0 +1,566 @@
+#include "LTerrainEditor.h"
+#include "LGenerationJob.h"
+
+#include "LTerrainComponentMainTask.h"
+
+#include "LandscapeComponent.h"
+#include "Landscape.h"
+#include "Materials/MaterialInstanceConstant.h"
+
+#define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
+
+LGenerationJob::LGenerationJob(LSystem& lSystem, ALandscape* terrain, LGenerationCache& cache, const FIntRect* componentRegion) :
+	LQueuedJob((componentRegion != nullptr) ? ELJobType::RegionGeneration : ELJobType::FullGeneration, (componentRegion != nullptr) ? 1 : 0),
+	lSystem(lSystem),
+	cache(cache),
+	terrainPtr(terrain),
+	componentRegion((componentRegion != nullptr) ? *componentRegion : FIntRect()),
+	pool(nullptr),
+	bRunning(false),
+	applySliceSeconds(0.01),
+	workerCount(1),
+	componentsInFlight(0),
+	componentsHeld(0),
+	maxComponentsInFlight(2),
+	releasedCount(0),
+	streamingBudgetBytes(0),
+	componentBufferBytes(0),
+	retainedBytes(0),
+	peakBufferBytes(0),
+	foliageActor(nullptr),
+	sampledFoliageCount(0),
+	trimmedFoliageCount(0),
+	componentStageStart(0.0),
+	foliageStageStart(0.0)
+{
+	SP.context = &cache.context;
+	SP.bCancelled = false;
+	SP.completedTileRows.Reset();
+	SP.dirtyComponentCount = 0;
+	SP.bStreaming = false;
+}
+
+LGenerationJob::~LGenerationJob()
+{
+	//tasks reference SP and FPs, they must never outlive the job
+	check(!bRunning);
+}
+
+bool LGenerationJob::Supersedes(const LQueuedJob& older) const
+{
+	if (older.type != ELJobType::FullGeneration && older.type != ELJobType::RegionGeneration) return false;
+
+	const LGenerationJob& olderGeneration = static_cast<const LGenerationJob&>(older);
+	if (olderGeneration.terrainPtr != terrainPtr) return false;
+	if (type == ELJobType::FullGeneration) return true;
+	if (older.type == ELJobType::FullGeneration) return false;
+
+	return componentRegion.Contains(olderGeneration.componentRegion.Min) &&
+		componentRegion.Max.X >= olderGeneration.componentRegion.Max.X &&
+		componentRegion.Max.Y >= olderGeneration.componentRegion.Max.Y;
+}
+
+//prepares against the current LSystem, then sets up everything the workers and Tick need
+void LGenerationJob::Start(FQueuedThreadPool* inPool, int32 poolThreadCount)
+{
+	pool = inPool;
+	workerCount = FMath::Max(poolThreadCount, 1);
+	ALandscape* terrain = terrainPtr.Get();
+	if (terrain == nullptr || SP.bCancelled) return;
+
+	const FIntRect* region = (type == ELJobType::RegionGeneration) ? &componentRegion : nullptr;
+	if (!LTerrainGeneration::PrepareGeneration(SP, lSystem, terrain, cache, region)) return;
+
+	terrain->Modify();
+	LTerrainGeneration::CaptureRegionBorderHeights(SP);
+
+	///ASSIGN LANDSCAPE MATERIAL PARAMETERS
+	UMaterialInstanceConstant* landscapeMat = Cast<UMaterialInstanceConstant>(terrain->LandscapeMaterial);
+	if (landscapeMat != nullptr)
+	{
+		for (int i = 0; i < lSystem.groundTextures.Num(); ++i)
+		{
+			if (lSystem.groundTextures[i]->texture.IsValid())
+			{
+				UTexture2D* diffuse = Cast<UTexture2D>(lSystem.groundTextures[i]->texture.GetAsset());
+				if (diffuse != nullptr)
+				{
+					FName diffuseParamName = FName(*FString::Printf(TEXT("Diffuse_%d"), i));
+					landscapeMat->SetTextureParameterValueEditorOnly(diffuseParamName, diffuse);
+				}
+			}
+
+			if (lSystem.groundTextures[i]->normalMap.IsValid())
+			{
+				UTexture2D* normalMap = Cast<UTexture2D>(lSystem.groundTextures[i]->normalMap.GetAsset());
+				if (normalMap != nullptr)
+				{
+					FName normMapParamName = FName(*FString::Printf(TEXT("Normal_%d"), i));
+					landscapeMat->SetTextureParameterValueEditorOnly(normMapParamName, normalMap);
+				}
+			}
+		}
+	}
+	///ASSIGN LANDSCAPE MATERIAL PARAMETERS END
+
+	///SET UP FOLIAGE SAMPLING
+	//poisson sampling only needs the landscape size, so it runs alongside the component tasks
+	//and each component is trimmed against the blend map as soon as it has been applied
+	int foliageTaskCount = 0;
+	for (LPatchId patchIdx : SP.usedPatchIdxs)
+	{
+		foliageTaskCount += SP.patches[patchIdx]->objectScatters.Num();
+	}
+
+	foliageActor = (foliageTaskCount > 0) ? AInstancedFoliageActor::GetInstancedFoliageActorForCurrentLevel(terrain->GetWorld(), true) : nullptr;
+	FPs.Reserve(foliageTaskCount);
+	for (LPatchId patchIdx : SP.usedPatchIdxs)
+	{
+		const TArray<LObjectScatterPtr>& objectScatters = SP.patches[patchIdx]->objectScatters;
+		for (int32 scatterIdx = 0; scatterIdx < objectScatters.Num(); ++scatterIdx)
+		{
+			int idx = FPs.Add(LFoliageParams());
+			FPs[idx].foliageType = Cast<UFoliageType>(objectScatters[scatterIdx]->meshAsset->foliageType.GetAsset());
+			FPs[idx].meshInfo = foliageActor->FindOrAddMesh(FPs[idx].foliageType);
+			FPs[idx].patchIdx = patchIdx;
+			FPs[idx].scatterIdx = scatterIdx;
+			FPs[idx].minRadius = objectScatters[scatterIdx]->minRadius;
+			FPs[idx].maxRadius = objectScatters[scatterIdx]->maxRadius;
+			FPs[idx].rngKey = ((uint32)patchIdx << 16) | (uint32)scatterIdx;
+			FPs[idx].bSampled = false;
+			FPs[idx].trimmedCount = 0;
+		}
+	}
+
+	foliagePatches.Init(false, SP.patches.Num());
+	for (const LFoliageParams& fp : FPs)
+	{
+		foliagePatches[fp.patchIdx] = true;
+	}
+
+	//generated instances in clean components near the dirty ones, so the samplers space new points against them
+	//read here since the foliage actor is only touched on the game thread
+	float componentWidthcm = terrain->GetActorScale().X * (SP.ComponentSizeVerts - 1);
+	for (LFoliageParams& fp : FPs)
+	{
+		FVector2D boundsMin, boundsMax;
+		FLFoliageTask::GetSampleBounds(SP, FMath::Max(fp.minRadius, 0.25f)*100.f, boundsMin, boundsMax);
+		for (const FFoliageInstance& instance : fp.meshInfo->Instances)
+		{
+			if (instance.ProceduralGuid != LGenerationCache::FoliageGuid) continue;
+
+			FVector local = instance.Location - terrain->GetActorLocation();
+			if (local.X < boundsMin.X || local.X >= boundsMax.X || local.Y < boundsMin.Y || local.Y >= boundsMax.Y) continue;
+			int compIdx = FMath::FloorToInt(local.Y / componentWidthcm) * SP.landscapeComponentCountSqrt + FMath::FloorToInt(local.X / componentWidthcm);
+			if (SP.dirtyComponents[compIdx]) continue;
+
+			fp.keptPoints.Add(FVector2D(local.X, local.Y));
+		}
+	}
+
+	bRunning = true;
+	componentStageStart = FPlatformTime::Seconds();
+	foliageStageStart = componentStageStart;
+
+	for (int idx = 0; idx < FPs.Num(); ++idx)
+	{
+		FOnFoliageCompletion onFoliageCompletion = FOnFoliageCompletion::CreateLambda([this, idx](bool bWasSuccessful) {
+			sampledFoliage.Enqueue(idx);
+		});
+		(new FAutoDeleteAsyncTask<FLFoliageTask>(FPs[idx], SP, onFoliageCompletion))->StartBackgroundTask(pool);
+	}
+
+	//clear instances we placed previously inside the regenerated components, while the samplers run
+	//hand placed instances of the same foliage types are left alone
+	TArray<FFoliageMeshInfo*> clearedMeshInfos = TArray<FFoliageMeshInfo*>();
+	for (const LFoliageParams& fp : FPs)
+	{
+		if (clearedMeshInfos.Contains(fp.meshInfo)) continue;
+		clearedMeshInfos.Add(fp.meshInfo);
+
+		TArray<int32> instancesToRemove = TArray<int32>();
+		for (int32 instanceIdx = 0; instanceIdx < fp.meshInfo->Instances.Num(); ++instanceIdx)
+		{
+			if (fp.meshInfo->Instances[instanceIdx].ProceduralGuid != LGenerationCache::FoliageGuid) continue;
+
+			FVector local = fp.meshInfo->Instances[instanceIdx].Location - terrain->GetActorLocation();
+			int compX = FMath::FloorToInt(local.X / componentWidthcm);
+			int compY = FMath::FloorToInt(local.Y / componentWidthcm);
+			if (compX < 0 || compY < 0 || compX >= SP.landscapeComponentCountSqrt || compY >= SP.landscapeComponentCountSqrt) continue;
+
+			if (SP.dirtyComponents[compY * SP.landscapeComponentCountSqrt + compX])
+				instancesToRemove.Add(instanceIdx);
+		}
+
+		if (instancesToRemove.Num() > 0)
+			fp.meshInfo->RemoveInstances(foliageActor, instancesToRemove);
+	}
+	///SET UP FOLIAGE SAMPLING END
+
+	//at most maxComponentsInFlight components hold buffers at once, applied ones included until foliage is done with them
+	//32x32 tiles keep a tile's outputs and the source rows it reads in cache, and split large components across every worker
+	maxComponentsInFlight = workerCount * 2;
+	componentBufferBytes = LTerrainGeneration::GetComponentBufferBytes(SP);
+	SP.bStreaming = lSystem.genSettings.bStreaming;
+	if (SP.bStreaming)
+	{
+		//components are released as they are applied, so the budget rather than the landscape size bounds memory
+		streamingBudgetBytes = (SIZE_T)FMath::Max(lSystem.genSettings.streamingBudgetMB, 1) * 1024 * 1024;
+		maxComponentsInFlight = FMath::Clamp((int32)(streamingBudgetBytes / componentBufferBytes), 1, maxComponentsInFlight);
+		SP.retainedComponents.Init(LRetainedComponent(), SP.landscapeComponentCount);
+	}
+	//released buffers beyond one window's worth are freed rather than kept for the next run
+	SP.context->SetComponentWindow(maxComponentsInFlight, SP.layerCount);
+	SP.context->foliageGrids.SetMaxFree(FMath::Min(FPs.Num(), workerCount));
+	SP.tileVerts = FMath::Min(LTerrainGeneration::DefaultTileVerts, SP.ComponentSizeVerts);
+	SP.tilesPerAxis = FMath::DivideAndRoundUp(SP.ComponentSizeVerts, SP.tileVerts);
+	SP.tilesPerComponent = FMath::Square(SP.tilesPerAxis);
+	SP.nextTile = 0;
+	SP.admittedComponents.Reset();
+	SP.activeWorkers.Reset();
+	SP.componentOrder.Reset(SP.dirtyComponentCount);
+	for (TConstSetBitIterator<> it(SP.dirtyComponents); it; ++it)
+	{
+		SP.componentOrder.Add(it.GetIndex());
+	}
+	SP.componentTilesRemaining.Init(FThreadSafeCounter(SP.tilesPerComponent), SP.componentOrder.Num());
+	SP.componentUniformPatchIdxs.Init(INDEX_NONE, SP.componentOrder.Num());
+	SP.tileKernel = FLTerrainComponentMainTask::SelectTileKernel(SP);
+	//shared border vertices are about 2/ComponentSizeVerts of the work, generated by the workers before any tile so no tile ever waits on a neighbor
+	FLTerrainComponentMainTask::PrepareSeams(SP);
+
+	appliedComponents.Reserve(SP.dirtyComponentCount);
+	blendedComponents.Init(false, SP.landscapeComponentCount);
+	AdmitComponents();
+	LaunchWorkers();
+}
+
+bool LGenerationJob::Tick()
+{
+	if (!bRunning) return false;
+
+	//nothing left to apply to
+	if (!terrainPtr.IsValid()) Cancel();
+
+	double sliceEnd = FPlatformTime::Seconds() + applySliceSeconds;
+	ApplyReadyComponents(sliceEnd);
+	AdmitComponents();
+	LaunchWorkers();
+	PlaceFoliage(sliceEnd);
+
+	//workers still touch SP after reporting their last component, so they must all have exited too
+	bool bDone = (SP.bCancelled) ?
+		AreTasksDone() :
+		(appliedComponents.Num() == SP.componentOrder.Num() && AreTasksDone() && releasedCount == appliedComponents.Num());
+
+	if (bDone)
+	{
+		Finish();
+		return false;
+	}
+	return true;
+}
+
+void LGenerationJob::Cancel()
+{
+	SP.bCancelled = true;
+}
+
+void LGenerationJob::CancelAndWait()
+{
+	if (!bRunning) return;
+
+	Cancel();
+	while (!AreTasksDone())
+	{
+		LaunchWorkers();
+		ApplyReadyComponents(0.0);
+		PlaceFoliage(0.0);
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	Finish();
+}
+
+//admits components in order while the window of components holding buffers has room, allocating their buffers for the workers
+//applied components stay in the window until every sampler has trimmed them, so slow foliage holds back generation instead of growing the live set
+//every entry is written by the workers, so nothing is zeroed, and buffers come warm from the context when a previous component or run released them
+void LGenerationJob::AdmitComponents()
+{
+	const int32 vertCount = FMath::Square(SP.ComponentSizeVerts);
+	for (int32 orderIdx = SP.admittedComponents.GetValue();
+		!SP.bCancelled && orderIdx < SP.componentOrder.Num() && componentsHeld < maxComponentsInFlight;
+		++orderIdx)
+	{
+		//retained copies are freed as foliage catches up, until then only admit what still fits
+		SIZE_T bufferBytes = (componentsHeld + 1) * componentBufferBytes + retainedBytes;
+		if (SP.bStreaming && bufferBytes > streamingBudgetBytes && (componentsHeld > 0 || retainedBytes > 0)) break;
+		peakBufferBytes = FMath::Max(peakBufferBytes, bufferBytes);
+
+		int32 compIdx = SP.componentOrder[orderIdx];
+		SP.componentUniformPatchIdxs[orderIdx] = LTerrainGeneration::GetUniformPatchIdx(SP, LTerrainGeneration::GetComponentSourceWindow(SP, compIdx));
+		SP.context->componentHeights.Acquire(SP.heightMaps[compIdx], vertCount);
+		SP.context->componentBlends.Acquire(SP.patchBlendData[compIdx], vertCount);
+		SP.weightMaps[compIdx].SetNum(SP.layerCount);
+		for (TArray<uint8>& layerWeights : SP.weightMaps[compIdx])
+		{
+			SP.context->layerWeights.Acquire(layerWeights, vertCount);
+		}
+
+		++componentsInFlight;
+		++componentsHeld;
+		SP.admittedComponents.Increment(); //publishes the buffers above to the workers
+	}
+}
+
+//keeps a worker per pool thread while seams or admitted tiles are unclaimed, workers exit when they run out
+//tiles only count once every seam is finished, until then the workers still on seams carry on into them
+//also runs after a cancel, admitted components must still report back before the job can finish
+void LGenerationJob::LaunchWorkers()
+{
+	const int32 seamCount = SP.seamSegments.Num();
+	while (SP.activeWorkers.GetValue() < workerCount &&
+		(SP.nextTile < seamCount || (SP.seamsRemaining.GetValue() == 0 && SP.nextTile < seamCount + SP.admittedComponents.GetValue() * SP.tilesPerComponent)))
+	{
+		FOnComponentReady onComponentReady = FOnComponentReady::CreateLambda([this](int32 compIdx) {
+			readyComponents.Enqueue(compIdx);
+		});
+		SP.activeWorkers.Increment();
+		(new FAutoDeleteAsyncTask<FLTerrainComponentMainTask>(SP, onComponentReady))->StartBackgroundTask(pool);
+	}
+}
+
+//apply finished components (can only be done in main thread) until the slice runs out
+//after a cancel, finished components are only drained, partially computed data is never applied
+bool LGenerationJob::ApplyReadyComponents(double sliceEnd)
+{
+	bool bDidWork = false;
+	int32 compIdx;
+	while ((SP.bCancelled || FPlatformTime::Seconds() < sliceEnd) && readyComponents.Dequeue(compIdx))
+	{
+		--componentsInFlight;
+		bDidWork = true;
+
+		if (SP.bCancelled)
+		{
+			ReleaseComponent(compIdx);
+			--componentsHeld;
+			continue;
+		}
+
+		ULandscapeComponent* landscapeComponent = SP.terrain->LandscapeComponents[compIdx];
+		blendedComponents[compIdx] = LTerrainGeneration::BlendRegionBorder(SP, compIdx, SP.heightMaps[compIdx]);
+		SP.regionBorderHeights[compIdx].Empty();
+		LTerrainGeneration::PackHeightmapData(SP.heightMaps[compIdx], packedHeights);
+		landscapeComponent->InitHeightmapData(packedHeights, false);
+
+		if (SP.layerCount != 0)
+			landscapeComponent->InitWeightmapData(SP.layerInfos, SP.weightMaps[compIdx]);
+		ReleaseWeightmaps(compIdx);
+
+		if (SP.bStreaming)
+		{
+			if (FPs.Num() > 0)
+			{
+				LTerrainGeneration::RetainComponent(SP, compIdx, foliagePatches, SP.retainedComponents[compIdx]);
+				retainedBytes += SP.retainedComponents[compIdx].GetAllocatedSize();
+			}
+			ReleaseComponent(compIdx);
+			--componentsHeld;
+		}
+
+		landscapeComponent->InvalidateLightingCache();
+		landscapeComponent->UpdateCollisionLayerData();
+		landscapeComponent->UpdateCachedBounds();
+		landscapeComponent->UpdateMaterialInstances();
+		//TODO: figure out other functions to call to update lightmap
+
+		appliedComponents.Add(compIdx);
+	}
+	return bDidWork;
+}
+
+//trim and place foliage for every applied component a sampler has not seen yet, then free what nothing needs anymore
+bool LGenerationJob::PlaceFoliage(double sliceEnd)
+{
+	bool bDidWork = false;
+
+	int32 foliageIdx;
+	while (sampledFoliage.Dequeue(foliageIdx))
+	{
+		FPs[foliageIdx].bSampled = true;
+		++sampledFoliageCount;
+		bDidWork = true;
+	}
+	if (SP.bCancelled) return bDidWork;
+
+	int32 minTrimmedCount = appliedComponents.Num();
+	for (LFoliageParams& fp : FPs)
+	{
+		if (fp.bSampled)
+		{
+			for (; fp.trimmedCount < appliedComponents.Num() && FPlatformTime::Seconds() < sliceEnd; ++fp.trimmedCount)
+			{
+				trimmedLocations.Reset();
+				FLFoliageTask::TrimComponent(SP, fp, appliedComponents[fp.trimmedCount], trimmedLocations);
+				for (const FVector& location : trimmedLocations)
+				{
+					FFoliageInstance instance = FFoliageInstance();
+					instance.Location = SP.terrain->GetActorLocation() + location;
+					instance.ProceduralGuid = LGenerationCache::FoliageGuid;
+					fp.meshInfo->AddInstance(foliageActor, fp.foliageType, instance);
+				}
+				fp.componentPoints[appliedComponents[fp.trimmedCount]].Empty();
+				++trimmedFoliageCount;
+				bDidWork = true;
+			}
+		}
+		minTrimmedCount = FMath::Min(minTrimmedCount, fp.trimmedCount);
+	}
+
+	//components every sampler is done with are no longer needed
+	for (; releasedCount < minTrimmedCount; ++releasedCount)
+	{
+		int32 releaseIdx = appliedComponents[releasedCount];
+		if (SP.bStreaming)
+		{
+			//buffers already went back on apply, only the retained copy is left
+			retainedBytes -= SP.retainedComponents[releaseIdx].GetAllocatedSize();
+			SP.retainedComponents[releaseIdx] = LRetainedComponent();
+		}
+		else
+		{
+			ReleaseComponent(releaseIdx);
+			--componentsHeld;
+		}
+		bDidWork = true;
+	}
+	return bDidWork;
+}
+
+//hands a component's buffers back to the context, they are empty afterwards
+void LGenerationJob::ReleaseComponent(int32 compIdx)
+{
+	SP.context->componentHeights.Release(SP.heightMaps[compIdx]);
+	SP.context->componentBlends.Release(SP.patchBlendData[compIdx]);
+	ReleaseWeightmaps(compIdx);
+}
+
+void LGenerationJob::ReleaseWeightmaps(int32 compIdx)
+{
+	for (TArray<uint8>& layerWeights : SP.weightMaps[compIdx])
+	{
+		SP.context->layerWeights.Release(layerWeights);
+	}
+	SP.weightMaps[compIdx].Empty();
+}
+
+bool LGenerationJob::AreTasksDone() const
+{
+	return componentsInFlight == 0 && SP.activeWorkers.GetValue() == 0 && sampledFoliageCount == FPs.Num();
+}
+
+void LGenerationJob::Finish()
+{
+	bRunning = false;
+	SP.verticalSeams.Empty();
+	SP.horizontalSeams.Empty();
+	SP.seamSegments.Empty();
+	packedHeights.Empty();
+	SP.retainedComponents.Empty();
+	//components still held after a cancel go back to the pool instead of being freed one by one with SP
+	for (int32 compIdx = 0; compIdx < SP.heightMaps.Num(); ++compIdx)
+	{
+		ReleaseComponent(compIdx);
+	}
+	retainedBytes = 0;
+	componentsHeld = 0;
+	if (!terrainPtr.IsValid()) return;
+
+	//landscape now matches these inputs for every applied component, which is all of them unless cancelled
+	//components left untouched keep their old hash, or 0 if nothing is known about them yet
+	//feathered border components don't match their inputs either, so a later full generation redoes them
+	if (cache.terrain.Get() != SP.terrain || cache.componentHashes.Num() != SP.landscapeComponentCount)
+	{
+		cache.terrain = SP.terrain;
+		cache.componentHashes.Init(0, SP.landscapeComponentCount);
+	}
+	for (int32 compIdx : appliedComponents)
+	{
+		cache.componentHashes[compIdx] = (blendedComponents[compIdx]) ? 0 : SP.componentHashes[compIdx];
+	}
+
+	UE_LOG(LogLTerrain, Log, TEXT("Terrain generation %s: %d of %d components applied in %.2f s"),
+		(SP.bCancelled) ? TEXT("cancelled") : TEXT("finished"),
+		appliedComponents.Num(),
+		SP.componentOrder.Num(),
+		FPlatformTime::Seconds() - componentStageStart);
+	UE_LOG(LogLTerrain, Verbose, TEXT("%.1f MB of generation buffers pooled for the next run"), SP.context->GetPooledBytes() / (1024.0 * 1024.0));
+	if (SP.bStreaming)
+		UE_LOG(LogLTerrain, Log, TEXT("Streaming generation peaked at %.1f MB of component buffers, budget %.1f MB"), peakBufferBytes / (1024.0 * 1024.0), streamingBudgetBytes / (1024.0 * 1024.0));
+}
+
+float LGenerationJob::GetComponentProgress() const
+{
+	int32 totalRows = SP.componentOrder.Num() * SP.ComponentSizeVerts * SP.tilesPerAxis;
+	if (totalRows == 0) return 1.f;
+
+	//computing tiles is most of the cost, applying is counted as the last tenth of each component
+	float computed = (float)SP.completedTileRows.GetValue() / totalRows;
+	float applied = (float)appliedComponents.Num() / SP.componentOrder.Num();
+	return FMath::Min(computed, 1.f) * 0.9f + applied * 0.1f;
+}
+
+float LGenerationJob::GetFoliageProgress() const
+{
+	if (FPs.Num() == 0) return 1.f;
+
+	int32 totalTrims = FPs.Num() * SP.componentOrder.Num();
+	float sampled = (float)sampledFoliageCount / FPs.Num();
+	float trimmed = (totalTrims > 0) ? (float)trimmedFoliageCount / totalTrims : 1.f;
+	return sampled * 0.5f + trimmed * 0.5f;
+}
+
+float LGenerationJob::GetProgress() const
+{
+	if (!bRunning) return 1.f;
+	if (FPs.Num() == 0) return GetComponentProgress();
+	return GetComponentProgress() * 0.8f + GetFoliageProgress() * 0.2f;
+}
+
+FText LGenerationJob::FormatEta(double stageStartTime, float stageProgress)
+{
+	if (stageProgress >= 1.f) return LOCTEXT("EtaDone", "done");
+	if (stageProgress <= 0.01f) return LOCTEXT("EtaUnknown", "estimating");
+
+	double elapsed = FPlatformTime::Seconds() - stageStartTime;
+	int32 remaining = FMath::CeilToInt(elapsed / stageProgress * (1.f - stageProgress));
+	return FText::Format(LOCTEXT("EtaFormat", "{0}:{1} left"), FText::AsNumber(remaining / 60), FText::FromString(FString::Printf(TEXT("%02d"), remaining % 60)));
+}
+
+FText LGenerationJob::GetStatusText() const
+{
+	if (!bRunning)
+	{
+		return (SP.bCancelled) ?
+			FText::Format(LOCTEXT("StatusCancelled", "Cancelled, {0} of {1} components applied"), FText::AsNumber(appliedComponents.Num()), FText::AsNumber(SP.componentOrder.Num())) :
+			FText::Format(LOCTEXT("StatusFinished", "Finished, {0} components applied"), FText::AsNumber(appliedComponents.Num()));
+	}
+
+	if (SP.bCancelled) return LOCTEXT("StatusCancelling", "Cancelling...");
+
+	float componentProgress = GetComponentProgress();
+	FText componentText = FText::Format(LOCTEXT("StatusComponents", "Components {0}/{1} ({2})"),
+		FText::AsNumber(appliedComponents.Num()),
+		FText::AsNumber(SP.componentOrder.Num()),
+		FormatEta(componentStageStart, componentProgress));
+	if (FPs.Num() == 0) return componentText;
+
+	FText foliageText = FText::Format(LOCTEXT("StatusFoliage", "Foliage {0}/{1} sampled ({2})"),
+		FText::AsNumber(sampledFoliageCount),
+		FText::AsNumber(FPs.Num()),
+		FormatEta(foliageStageStart, GetFoliageProgress()));
+	return FText::Format(LOCTEXT("StatusBoth", "{0}, {1}"), componentText, foliageText);
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,119 @@
+#include "LTerrainEditor.h"
+#include "LGenerationQueue.h"
+
+LGenerationQueue::LGenerationQueue() :
+	pool(nullptr),
+	poolThreadCount(0),
+	requestedThreadCount(0),
+	nextSequence(0)
+{
+	tickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &LGenerationQueue::Tick));
+}
+
+LGenerationQueue::~LGenerationQueue()
+{
+	Shutdown();
+	FTicker::GetCoreTicker().RemoveTicker(tickerHandle);
+}
+
+void LGenerationQueue::Enqueue(LQueuedJobPtr job)
+{
+	job->sequence = nextSequence++;
+
+	//drop queued work this job makes redundant, and stop the running job if it is made redundant too
+	pendingJobs.RemoveAll([&job](const LQueuedJobPtr& older) {
+		return job->Supersedes(*older);
+	});
+	if (activeJob.IsValid() && activeJob->IsRunning() && job->Supersedes(*activeJob))
+		activeJob->Cancel();
+
+	int32 insertIdx = 0;
+	while (insertIdx < pendingJobs.Num() && pendingJobs[insertIdx]->priority >= job->priority) ++insertIdx;
+	pendingJobs.Insert(job, insertIdx);
+}
+
+void LGenerationQueue::CancelAll()
+{
+	pendingJobs.Empty();
+	if (activeJob.IsValid()) activeJob->Cancel();
+}
+
+void LGenerationQueue::Shutdown()
+{
+	pendingJobs.Empty();
+	if (activeJob.IsValid())
+	{
+		activeJob->CancelAndWait();
+		lastJob = activeJob;
+		activeJob.Reset();
+	}
+	DestroyPool();
+}
+
+int32 LGenerationQueue::GetPendingCount(ELJobType type) const
+{
+	int32 count = 0;
+	for (const LQueuedJobPtr& job : pendingJobs)
+	{
+		if (job->type == type) ++count;
+	}
+	return count;
+}
+
+void LGenerationQueue::SetPoolSize(int32 threadCount)
+{
+	requestedThreadCount = FMath::Max(threadCount, 0);
+}
+
+bool LGenerationQueue::Tick(float deltaTime)
+{
+	if (activeJob.IsValid() && !activeJob->Tick())
+	{
+		lastJob = activeJob;
+		activeJob.Reset();
+	}
+
+	//start the next job, skipping any that finish immediately (nothing to regenerate)
+	while (!activeJob.IsValid() && pendingJobs.Num() > 0)
+	{
+		EnsurePool();
+		activeJob = pendingJobs[0];
+		pendingJobs.RemoveAt(0);
+		activeJob->Start(pool, poolThreadCount);
+		if (!activeJob->IsRunning())
+		{
+			lastJob = activeJob;
+			activeJob.Reset();
+		}
+	}
+
+	return true;
+}
+
+//the pool is only ever resized while no job is running, so no task can be queued on it
+void LGenerationQueue::EnsurePool()
+{
+	int32 threadCount = requestedThreadCount;
+	if (threadCount == 0)
+	{
+		//leave the game and render threads their own cores
+		threadCount = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 2, 1);
+	}
+
+	if (pool != nullptr && poolThreadCount == threadCount) return;
+	DestroyPool();
+
+	pool = FQueuedThreadPool::Allocate();
+	verify(pool->Create(threadCount, 128 * 1024, TPri_BelowNormal));
+	poolThreadCount = threadCount;
+}
+
+void LGenerationQueue::DestroyPool()
+{
+	if (pool == nullptr) return;
+
+	pool->Destroy();
+	delete pool;
+	pool = nullptr;
+	poolThreadCount = 0;
+}
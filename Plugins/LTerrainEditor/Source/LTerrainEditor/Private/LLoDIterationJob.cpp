@@ -0,0 +1,70 @@
+#include "LTerrainEditor.h"
+#include "LLoDIterationJob.h"
+
+#define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
+
+LLoDIterationJob::LLoDIterationJob(LSystem& lSystem, FOnLoDIterated onIterated) :
+	LQueuedJob(ELJobType::LoDIteration, 2),
+	lSystem(lSystem),
+	sourceWidth(0),
+	sourceHeight(0),
+	onIterated(onIterated),
+	bCancelled(false),
+	bRunning(false)
+{
+	bDone = false;
+}
+
+LLoDIterationJob::~LLoDIterationJob()
+{
+	//the task references members of the job
+	check(!bRunning);
+}
+
+void LLoDIterationJob::Start(FQueuedThreadPool* pool, int32 poolThreadCount)
+{
+	if (bCancelled || lSystem.lSystemLoDs.Num() == 0) return;
+
+	//everything touching symbol pointers happens here and in Tick, on the game thread
+	const LSymbol2DMap& source = *lSystem.lSystemLoDs[lSystem.lSystemLoDs.Num() - 1];
+	rulesSnapshot.Build(lSystem);
+	rulesSnapshot.ToIds(source, sourceIds);
+	sourceHeight = source.Num();
+	sourceWidth = (sourceHeight > 0) ? source[0].Num() : 0;
+
+	bRunning = true;
+	(new FAutoDeleteAsyncTask<FLLoDIterationTask>(rulesSnapshot, sourceIds, sourceWidth, sourceHeight, newIds, bDone))->StartBackgroundTask(pool);
+}
+
+bool LLoDIterationJob::Tick()
+{
+	if (!bRunning) return false;
+	if (!bDone) return true;
+
+	bRunning = false;
+	if (!bCancelled)
+	{
+		LSymbol2DMapPtr newLoD = rulesSnapshot.ToMap(newIds, sourceWidth * LSystem::DIMS, sourceHeight * LSystem::DIMS);
+		lSystem.lSystemLoDs.Add(newLoD);
+		onIterated.ExecuteIfBound(newLoD);
+	}
+	return false;
+}
+
+void LLoDIterationJob::CancelAndWait()
+{
+	Cancel();
+	while (bRunning && !bDone)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+	bRunning = false;
+}
+
+FText LLoDIterationJob::GetStatusText() const
+{
+	if (bRunning) return LOCTEXT("LoDIterating", "Iterating LoD...");
+	return (bCancelled) ? LOCTEXT("LoDCancelled", "LoD iteration cancelled") : LOCTEXT("LoDDone", "LoD iteration finished");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -1,5 +1,6 @@
 #include "LTerrainEditor.h"
 #include "LMapEditor.h"
+#include "LLoDIterationJob.h"
 #include "LMapView.h"
 
 #define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
@@ -85,16 +86,22 @@ void SLMapEditor::Construct(const FArguments & args)
 	];
 }
 
-//generates new LoD from highest current and adds it
+//queues generation of a new LoD from the highest current one, it is added once the generation queue gets to it
 FReply SLMapEditor::OnAddLoDClicked()
 {
-	if (lTerrainModule->lSystem.lSystemLoDs.Num() > 4) return FReply::Handled();
-	LSymbol2DMapPtr highestLoD = lTerrainModule->lSystem.lSystemLoDs[lTerrainModule->lSystem.lSystemLoDs.Num() - 1];
-	LSymbol2DMapPtr newLoD = lTerrainModule->lSystem.IterateLString(highestLoD);
-	lTerrainModule->lSystem.lSystemLoDs.Add(newLoD);
+	TSharedPtr<LGenerationQueue> queue = lTerrainModule->generationQueue;
+	//LoDs still to come count towards the cap, queued or already iterating
+	int32 lodCount = lTerrainModule->lSystem.lSystemLoDs.Num() + queue->GetPendingCount(ELJobType::LoDIteration) + (queue->IsActive(ELJobType::LoDIteration) ? 1 : 0);
+	if (lodCount > 4) return FReply::Handled();
 
-	lodListWidget->SetSelection(newLoD);
-	lodListWidget->RequestListRefresh();
+	TWeakPtr<SListView<LSymbol2DMapPtr>> weakLoDList = lodListWidget;
+	queue->Enqueue(MakeShareable(new LLoDIterationJob(lTerrainModule->lSystem, FOnLoDIterated::CreateLambda([weakLoDList](LSymbol2DMapPtr newLoD) {
+		TSharedPtr<SListView<LSymbol2DMapPtr>> lodList = weakLoDList.Pin();
+		if (!lodList.IsValid()) return;
+
+		lodList->SetSelection(newLoD);
+		lodList->RequestListRefresh();
+	}))));
 
 	return FReply::Handled();
 }
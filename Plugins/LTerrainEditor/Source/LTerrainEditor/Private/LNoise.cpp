@@ -1,23 +1,27 @@
 #include "LTerrainEditor.h"
 #include "LNoise.h"
+#include "LRandom.h"
 
-LNoise::LNoise(ENoiseType noiseType)
+LNoise::LNoise(ENoiseType noiseType, int32 seedVal)
 {
 	this->noiseType = noiseType;
 
-	InitNoise(FMath::RandRange(INT32_MIN, INT32_MAX));
+	InitNoise(seedVal);
 }
 
-LNoise::LNoise(ENoiseType noiseType, int32 seedVal)
+//same frequency and amplitude, different seed
+LNoise::LNoise(const LNoise& source, int32 seedVal) :
+	frequency(source.frequency),
+	amplitude(source.amplitude)
 {
-	this->noiseType = noiseType;
+	this->noiseType = source.noiseType;
 
 	InitNoise(seedVal);
 }
 
 void LNoise::Reseed()
 {
-	noiseObject->Initialize(FMath::RandRange(INT32_MIN, INT32_MAX));
+	noiseObject->Initialize((int32)LRandom::Hash((uint32)noiseObject->GetSeed(), ELRandomStage::NoiseCreation, 1));
 }
 
 void LNoise::Reseed(int32 seedVal)
@@ -30,6 +34,11 @@ ENoiseType LNoise::GetNoiseType()
 	return noiseType;
 }
 
+int32 LNoise::GetSeed()
+{
+	return noiseObject->GetSeed();
+}
+
 float LNoise::Noise(float x, float y)
 {
 	//returns within range [-amplitude/2, amplitude/2]
@@ -61,7 +70,6 @@ void LNoise::InitNoise(int32 seedVal)
 
 LPerlinNoise::LPerlinNoise()
 {
-	gradVecRotDistribution = std::uniform_real_distribution<float>(0.f, 360.f);
 }
 
 float LPerlinNoise::Noise(float x, float y)
@@ -94,12 +102,8 @@ void LPerlinNoise::Initialize(int32 seedVal)
 
 float LPerlinNoise::DotGrad(int ix, int iy, float x, float y)
 {
-	//get our vector using our seed
-	//to get semi-unique seed val from ix, iy, using: (ix*primeA + ix) + (iy*primeB + iy)
-	RNGLock.Lock(); //lock mutex
-	generator.seed(seed + (ix * 47 + ix) + (iy * 113 + iy));
-	FVector2D gridVec = FVector2D(1.f, 0.f).GetRotated(gradVecRotDistribution(generator));
-	RNGLock.Unlock(); //unlock mutex
+	//gradient angle is a pure function of the seed and the lattice point, so any thread computes the same one
+	FVector2D gridVec = FVector2D(1.f, 0.f).GetRotated(LRandom::FRandRange(0.f, 360.f, (uint32)seed, ELRandomStage::PerlinGradient, (uint32)ix, (uint32)iy));
 
 	float dx = x - ix;
 	float dy = y - iy;
@@ -118,36 +122,33 @@ float LColoredNoise::TAU = 2.f*PI;
 LColoredNoise::LColoredNoise(float exponent)
 {
 	this->exponent = exponent;
-	tauShiftDistribution = std::uniform_real_distribution<float>(0.f, TAU);
-	generate2ndSeed = std::uniform_int_distribution<int>(INT32_MIN, INT32_MAX);
-}
 
-float LColoredNoise::Noise(float x, float y)
-{
-	RNGLock.Lock(); //lock mutex
-	generatorX.seed(seed + y);
-	generatorY.seed(seed2 + x);
-	TArray<float> values = TArray<float>();
-	TArray<float> weights = TArray<float>();
+	//frequency weights only depend on the exponent
 	float sumWeights = 0.f;
-	for (int freq = 1; freq < 31; ++freq)
+	for (int freq = 1; freq <= FREQ_COUNT; ++freq)
 	{
-		//will always generate the same 60 number shift sequence since we seed at start
-		float shiftX = tauShiftDistribution(generatorX);
-		float shiftY = tauShiftDistribution(generatorY);
-
-		values.Add(FMath::Max(FMath::Sin((TAU*x + shiftX)*freq), FMath::Sin((TAU*y + shiftY)*freq)));
-
-		float weight = FMath::Pow(freq, exponent);
-		sumWeights += weight;
-		weights.Add(weight);
+		sumWeights += FMath::Pow(freq, exponent);
 	}
-	RNGLock.Unlock(); //unlock mutex
+	for (int freq = 1; freq <= FREQ_COUNT; ++freq)
+	{
+		normalizedWeights[freq - 1] = FMath::Pow(freq, exponent) / sumWeights;
+	}
+}
+
+float LColoredNoise::Noise(float x, float y)
+{
+	//shifts are keyed on the whole row / column, the same 60 number shift sequence for every point on it
+	const uint32 row = (uint32)FMath::FloorToInt(y);
+	const uint32 column = (uint32)FMath::FloorToInt(x);
 
 	float weightedValue = 0.f;
-	for (int i = 0; i < values.Num(); ++i)
+	for (int freq = 1; freq <= FREQ_COUNT; ++freq)
 	{
-		weightedValue += values[i] * (weights[i] / sumWeights);
+		float shiftX = LRandom::FRandRange(0.f, TAU, (uint32)seed, ELRandomStage::ColoredNoiseShiftX, row, freq);
+		float shiftY = LRandom::FRandRange(0.f, TAU, (uint32)seed2, ELRandomStage::ColoredNoiseShiftY, column, freq);
+
+		float value = FMath::Max(FMath::Sin((TAU*x + shiftX)*freq), FMath::Sin((TAU*y + shiftY)*freq));
+		weightedValue += value * normalizedWeights[freq - 1];
 	}
 
 	return weightedValue;
@@ -156,7 +157,5 @@ float LColoredNoise::Noise(float x, float y)
 void LColoredNoise::Initialize(int32 seedVal)
 {
 	this->seed = seedVal;
-	//generate 2nd seed
-	generatorX.seed(seedVal);
-	this->seed2 = generate2ndSeed(generatorX);
+	this->seed2 = (int32)LRandom::Hash((uint32)seedVal, ELRandomStage::ColoredNoiseSeed, 0);
 }
@@ -418,7 +418,7 @@ void SLPatchView::Reconstruct(LPatchPtr item)
 
 FReply SLPatchView::OnNoiseAdded()
 {
-	LNoisePtr newNoise = LNoisePtr(new LNoise(ENoiseType::PERLIN));
+	LNoisePtr newNoise = LNoisePtr(new LNoise(ENoiseType::PERLIN, FLTerrainEditorModule::GetModule()->lSystem.NextNoiseSeed()));
 	newNoise->frequency = 1.f;
 	newNoise->amplitude = 2.f;
 	patch->noiseMaps.Add(newNoise);
@@ -597,7 +597,7 @@ void SLNoiseView::Reconstruct(LNoisePtr item)
 			.OptionsSource(&noiseNames)
 			.OnSelectionChanged_Lambda([item, this](TSharedPtr<FString> string, ESelectInfo::Type selectType) {
 				ENoiseType newNoiseType = (ENoiseType)noiseNames.Find(string);
-				*item = LNoise(newNoiseType);
+				*item = LNoise(newNoiseType, FLTerrainEditorModule::GetModule()->lSystem.NextNoiseSeed());
 				item->frequency = 1.f;
 				item->amplitude = 2.f;
 				this->Reconstruct(item);
@@ -691,6 +691,163 @@ void SLPaintWeightView::Reconstruct(LPaintWeightPtr item)
 				})
 			]
 		]
+		+ SVerticalBox::Slot()
+		.Padding(2)
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("PaintWeight", "Weight:"))
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(SSpinBox<float>)
+				.MinDesiredWidth(80.f)
+				.MinValue(0.f)
+				.MaxValue(10.f)
+				.Value_Lambda([item]()->float {
+					return item->weight;
+				})
+				.OnValueChanged_Lambda([item](float val) {
+					item->weight = val;
+				})
+			]
+		]
+		+ SVerticalBox::Slot()
+		.Padding(2)
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.Text(LOCTEXT("PaintUseNoise", "Break Up With Noise"))
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(SCheckBox)
+				.IsChecked_Lambda([item]()->ECheckBoxState {
+					return (item->noiseMap.IsValid()) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+				})
+				.OnCheckStateChanged_Lambda([item, this](ECheckBoxState checkstate) {
+					if (checkstate == ECheckBoxState::Checked)
+					{
+						item->noiseMap = LNoisePtr(new LNoise(ENoiseType::PERLIN, FLTerrainEditorModule::GetModule()->lSystem.NextNoiseSeed()));
+						item->noiseMap->frequency = 1.f;
+						item->noiseMap->amplitude = 2.f;
+					}
+					else
+					{
+						item->noiseMap = LNoisePtr();
+					}
+					this->Reconstruct(item);
+				})
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.Text(LOCTEXT("PaintAboveThreshold", " Paint Above Threshold"))
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(SCheckBox)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.IsChecked_Lambda([item]()->ECheckBoxState {
+					return (item->bUseAboveThreshold) ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+				})
+				.OnCheckStateChanged_Lambda([item](ECheckBoxState checkstate) {
+					item->bUseAboveThreshold = (checkstate == ECheckBoxState::Checked);
+				})
+			]
+		]
+		+ SVerticalBox::Slot()
+		.Padding(2)
+		.AutoHeight()
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.Text(LOCTEXT("PaintThreshold", "Threshold:"))
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(SSpinBox<float>)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.MinDesiredWidth(80.f)
+				.MinValue(-10.f)
+				.MaxValue(10.f)
+				.Value_Lambda([item]()->float {
+					return item->threshold;
+				})
+				.OnValueChanged_Lambda([item](float val) {
+					item->threshold = val;
+				})
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(STextBlock)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.Text(LOCTEXT("PaintFeather", " Feather:"))
+			]
+			+ SHorizontalBox::Slot()
+			.Padding(2)
+			.AutoWidth()
+			[
+				SNew(SSpinBox<float>)
+				.IsEnabled_Lambda([item]()->bool {
+					return item->noiseMap.IsValid();
+				})
+				.MinDesiredWidth(80.f)
+				.MinValue(0.f)
+				.MaxValue(10.f)
+				.Value_Lambda([item]()->float {
+					return item->thresholdFeather;
+				})
+				.OnValueChanged_Lambda([item](float val) {
+					item->thresholdFeather = val;
+				})
+			]
+		]
+		+ SVerticalBox::Slot()
+		.Padding(2)
+		.AutoHeight()
+		[
+			SNew(SLNoiseView)
+			.Noise(item->noiseMap)
+		]
 	];
 }
 
@@ -1,5 +1,6 @@
 #include "LTerrainEditor.h"
 #include "LSystem.h"
+#include "LRandom.h"
 
 //LSystem START
 
@@ -9,6 +10,7 @@ void LSystem::Reset()
 	symbols = TArray<LSymbolPtr>();
 	patches = TArray<LPatchPtr>();
 	lSystemLoDs = TArray<LSymbol2DMapPtr>();
+	createdNoiseCount = 0;
 
 	GenerateSomeDefaults();
 }
@@ -79,113 +81,217 @@ void LSystem::GenerateSomeDefaults()
 
 LSymbol2DMapPtr LSystem::IterateLString(LSymbol2DMapPtr source)
 {
-	int idim = source->Num();
-	int jdim = (*source)[0].Num();
-	LSymbol2DMapPtr newSystemString = LSymbol::CreateLSymbolMap(idim * LSystem::DIMS, jdim * LSystem::DIMS);
+	LSystemHandles handles;
+	handles.Build(*this);
+	return handles.IterateLString(*source);
+}
 
-	for (int i = 0; i < idim; ++i)
+LPatchPtr LSystem::GetLPatchMatch(LSymbolPtr toMatch)
+{
+	for (const LPatchPtr& patch : patches)
 	{
-		for (int j = 0; j < jdim; ++j)
-		{
-			LRulePtr matchingRule = GetLRuleMatch(source, j, i);
+		if (toMatch == patch->matchVal)
+			return patch;
+	}
+
+	return LPatchPtr(new LPatch());
+}
+
+LSymbolPtr LSystem::GetMapSymbolFrom01Coords(LSymbol2DMapPtr map, float xPercCoord, float yPercCoord)
+{
+	xPercCoord = FMath::Clamp(xPercCoord, 0.f, 0.99999f);
+	yPercCoord = FMath::Clamp(yPercCoord, 0.f, 0.99999f);
+
+	int ydim = (*map).Num();
+	int xdim = (*map)[0].Num();
+
+	int xIdx = FMath::FloorToInt(xPercCoord * xdim);
+	int yIdx = FMath::FloorToInt(yPercCoord * ydim);
+	return (*map)[yIdx][xIdx];
+}
+
+LSymbolPtr LSystem::GetDefaultSymbol()
+{
+	return (symbols.Num() > 0) ? symbols[0] : LSymbolPtr();
+}
+
+//keyed on the project seed and a count kept in the LSystem, so the same editing steps on a project always give the same seeds
+int32 LSystem::NextNoiseSeed()
+{
+	return (int32)LRandom::Hash((uint32)genSettings.seed, ELRandomStage::NoiseCreation, createdNoiseCount++);
+}
+
+//LSystem END
+//LSystemHandles START
+
+void LSystemHandles::Build(const LSystem& lSystem)
+{
+	symbols.Reset();
+	symbolIds.Reset();
+	symbolRules.Reset();
+	symbolPatches.Reset();
+	GetSymbolId(LSymbolPtr());
+	GetSymbolId(LSymbol::MatchAny());
+	for (const LSymbolPtr& symbol : lSystem.symbols)
+	{
+		GetSymbolId(symbol);
+	}
 
-			for (int i2 = 0; i2 < DIMS; ++i2)
+	rules.SetNumUninitialized(lSystem.rules.Num());
+	for (LRuleId ruleId = 0; ruleId < lSystem.rules.Num(); ++ruleId)
+	{
+		const LRule& rule = *lSystem.rules[ruleId];
+		LCompiledRule& compiled = rules[ruleId];
+		compiled.matchVal = GetSymbolId(rule.matchVal);
+		compiled.bMatchNeighbors = rule.bMatchNeighbors;
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
 			{
-				for (int j2 = 0; j2 < DIMS; ++j2)
-				{
-					(*newSystemString)[i*DIMS + i2][j*DIMS + j2] = (*(matchingRule->replacementVals))[i2][j2];
-				}
+				compiled.neighbors[i * 3 + j] = GetSymbolId((*rule.matchNeighborsMap)[i][j]);
+			}
+		}
+		for (int i = 0; i < LSystem::DIMS; ++i)
+		{
+			for (int j = 0; j < LSystem::DIMS; ++j)
+			{
+				compiled.replacement[i * LSystem::DIMS + j] = GetSymbolId((*rule.replacementVals)[i][j]);
 			}
 		}
+		symbolRules[compiled.matchVal].Add(ruleId);
 	}
 
-	return newSystemString;
+	//backwards, so the first patch matching a symbol wins
+	for (LPatchId patchIdx = lSystem.patches.Num() - 1; patchIdx >= 0; --patchIdx)
+	{
+		symbolPatches[GetSymbolId(lSystem.patches[patchIdx]->matchVal)] = patchIdx;
+	}
 }
 
-LRulePtr LSystem::GetLRuleMatch(LSymbol2DMapPtr map, int xIdx, int yIdx)
+LSymbolId LSystemHandles::GetSymbolId(const LSymbolPtr& symbol)
 {
-	TArray<LRulePtr> matches = TArray<LRulePtr>();
-
-	LSymbolPtr toMatch = (*map)[yIdx][xIdx]; //middle element
+	const LSymbolId* found = symbolIds.Find(symbol.Get());
+	if (found != nullptr) return *found;
+
+	LSymbolId symbolId = symbols.Add(symbol);
+	symbolIds.Add(symbol.Get(), symbolId);
+	symbolRules.AddDefaulted();
+	symbolPatches.Add(INDEX_NONE);
+	return symbolId;
+}
 
-	for (LRulePtr rule : rules)
+void LSystemHandles::ToIds(const LSymbol2DMap& map, TArray<LSymbolId>& outIds)
+{
+	const int32 height = map.Num();
+	const int32 width = (height > 0) ? map[0].Num() : 0;
+	outIds.SetNumUninitialized(width * height);
+
+	//maps are mostly runs of the same symbol, so the last lookup is reused
+	const LSymbol* lastSymbol = nullptr;
+	LSymbolId lastId = NullSymbolId;
+	for (int32 y = 0; y < height; ++y)
 	{
-		if (toMatch == rule->matchVal)
+		const TArray<LSymbolPtr>& row = map[y];
+		for (int32 x = 0; x < width; ++x)
 		{
-			//add rule to matches if it 
-			if (!rule->bMatchNeighbors) matches.Add(rule);
-			else
+			if (row[x].Get() != lastSymbol)
 			{
-				bool bFailMatch = false;
-				for (int i = 0; i < 3; ++i)
-				{
-					for (int j = 0; j < 3; ++j)
-					{
-						if (xIdx + j - 1 < 0 || xIdx + j - 1 > (*map).Num() ||
-							yIdx + i - 1 < 0 || yIdx + i - 1 > (*map)[0].Num())
-						{
-							continue;
-						}
-
-						if ((*rule->matchNeighborsMap)[i][j] != LSymbol::MatchAny() &&
-							(*map)[yIdx + i - 1][xIdx + j - 1] != (*rule->matchNeighborsMap)[i][j])
-						{
-							bFailMatch = true;
-						}
-					}
-				}
-
-				if (!bFailMatch) matches.Add(rule);
+				lastSymbol = row[x].Get();
+				lastId = GetSymbolId(row[x]);
 			}
+			outIds[y * width + x] = lastId;
 		}
 	}
+}
 
-	//if no match found, create a rule to propegate toMatch (default behavior)
-	if (matches.Num() == 0)
-		return LRule::CreatePropegateRule(toMatch, toMatch);
-	else
+LSymbol2DMapPtr LSystemHandles::ToMap(const TArray<LSymbolId>& ids, int32 width, int32 height) const
+{
+	LSymbol2DMapPtr map = LSymbol2DMapPtr(new LSymbol2DMap());
+	map->SetNum(height);
+	for (int32 y = 0; y < height; ++y)
 	{
-		//TODO: better metric for figuring out best match from matches array
-		//return first neighbor matching rule which matched
-		//failing that, return the first non-neighbor matching rule
-		for (LRulePtr rule : matches)
+		TArray<LSymbolPtr>& row = (*map)[y];
+		row.Reserve(width);
+		for (int32 x = 0; x < width; ++x)
 		{
-			if (rule->bMatchNeighbors) return rule;
+			row.Add(symbols[ids[y * width + x]]);
 		}
-		return matches[0];
 	}
+	return map;
 }
 
-LPatchPtr LSystem::GetLPatchMatch(LSymbolPtr toMatch)
+//the first neighbor matching rule which matched, failing that the first non-neighbor matching rule
+LRuleId LSystemHandles::MatchRule(const LSymbolId* map, int32 width, int32 height, int32 x, int32 y) const
 {
-	for (LPatchPtr patch : patches)
+	LRuleId firstMatch = INDEX_NONE;
+	for (LRuleId ruleId : symbolRules[map[y * width + x]])
 	{
-		if (toMatch == patch->matchVal)
-			return patch;
-	}
+		const LCompiledRule& rule = rules[ruleId];
+		if (!rule.bMatchNeighbors)
+		{
+			if (firstMatch == INDEX_NONE) firstMatch = ruleId;
+			continue;
+		}
 
-	return LPatchPtr(new LPatch());
-}
+		bool bFailMatch = false;
+		for (int i = 0; i < 3 && !bFailMatch; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				//neighbors off the map always match
+				if (x + j - 1 < 0 || x + j - 1 >= width || y + i - 1 < 0 || y + i - 1 >= height)
+					continue;
 
-LSymbolPtr LSystem::GetMapSymbolFrom01Coords(LSymbol2DMapPtr map, float xPercCoord, float yPercCoord)
-{
-	xPercCoord = FMath::Clamp(xPercCoord, 0.f, 0.99999f);
-	yPercCoord = FMath::Clamp(yPercCoord, 0.f, 0.99999f);
+				LSymbolId neighbor = rule.neighbors[i * 3 + j];
+				if (neighbor != MatchAnySymbolId && map[(y + i - 1) * width + x + j - 1] != neighbor)
+				{
+					bFailMatch = true;
+					break;
+				}
+			}
+		}
 
-	int ydim = (*map).Num();
-	int xdim = (*map)[0].Num();
+		if (!bFailMatch) return ruleId;
+	}
+	return firstMatch;
+}
 
-	int xIdx = FMath::FloorToInt(xPercCoord * xdim);
-	int yIdx = FMath::FloorToInt(yPercCoord * ydim);
-	return (*map)[yIdx][xIdx];
+//each cell becomes a DIMS x DIMS block, the replacement of its matching rule or the cell's own symbol
+void LSystemHandles::IterateIds(const TArray<LSymbolId>& sourceIds, int32 width, int32 height, TArray<LSymbolId>& outIds) const
+{
+	const int32 dims = LSystem::DIMS;
+	const int32 newWidth = width * dims;
+	outIds.SetNumUninitialized(newWidth * height * dims);
+	for (int32 y = 0; y < height; ++y)
+	{
+		for (int32 x = 0; x < width; ++x)
+		{
+			LRuleId ruleId = MatchRule(sourceIds.GetData(), width, height, x, y);
+			LSymbolId* block = outIds.GetData() + y * dims * newWidth + x * dims;
+			for (int32 i2 = 0; i2 < dims; ++i2)
+			{
+				for (int32 j2 = 0; j2 < dims; ++j2)
+				{
+					block[i2 * newWidth + j2] = (ruleId != INDEX_NONE) ? rules[ruleId].replacement[i2 * dims + j2] : sourceIds[y * width + x];
+				}
+			}
+		}
+	}
 }
 
-LSymbolPtr LSystem::GetDefaultSymbol()
+LSymbol2DMapPtr LSystemHandles::IterateLString(const LSymbol2DMap& source)
 {
-	return (symbols.Num() > 0) ? symbols[0] : LSymbolPtr();
+	const int32 height = source.Num();
+	const int32 width = source[0].Num();
+	TArray<LSymbolId> sourceIds;
+	ToIds(source, sourceIds);
+
+	TArray<LSymbolId> newIds;
+	IterateIds(sourceIds, width, height, newIds);
+	return ToMap(newIds, width * LSystem::DIMS, height * LSystem::DIMS);
 }
 
-//LSystem END
+//LSystemHandles END
 //LSymbol START
 
 LSymbolPtr LSymbol::_matchAny = LSymbolPtr(new LSymbol('?', "Match Any"));
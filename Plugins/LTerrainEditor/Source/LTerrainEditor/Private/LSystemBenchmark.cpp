@@ -0,0 +1,186 @@
+#include "LTerrainEditor.h"
+#include "LSystemBenchmark.h"
+
+void LSystemBenchmark::BuildSyntheticLSystem(LSystem& lSystem, const LSystemBenchmarkParams& params)
+{
+	FRandomStream stream = FRandomStream(params.seed);
+
+	lSystem.rules = TArray<LRulePtr>();
+	lSystem.symbols = TArray<LSymbolPtr>();
+	lSystem.patches = TArray<LPatchPtr>();
+	lSystem.lSystemLoDs = TArray<LSymbol2DMapPtr>();
+
+	int symbolCount = FMath::Max(params.symbolCount, 1);
+	for (int i = 0; i < symbolCount; ++i)
+	{
+		lSystem.symbols.Add(LSymbolPtr(new LSymbol('a' + (i % 26), FString::Printf(TEXT("Bench %d"), i))));
+	}
+
+	int neighborRuleCount = FMath::RoundToInt(params.ruleCount * FMath::Clamp(params.neighborRuleFraction, 0.f, 1.f));
+	for (int r = 0; r < params.ruleCount; ++r)
+	{
+		//cycle match symbols so every symbol has at least one rule when ruleCount >= symbolCount
+		LSymbolPtr matchVal = lSystem.symbols[r % symbolCount];
+
+		LSymbol2DMapPtr replacement = LSymbol::CreateLSymbolMap(LSystem::DIMS, LSystem::DIMS);
+		for (int i = 0; i < LSystem::DIMS; ++i)
+		{
+			for (int j = 0; j < LSystem::DIMS; ++j)
+			{
+				(*replacement)[i][j] = lSystem.symbols[stream.RandRange(0, symbolCount - 1)];
+			}
+		}
+
+		LRulePtr rule = LRule::CreateRule(matchVal, replacement);
+		rule->name = FString::Printf(TEXT("Bench Rule %d"), r);
+
+		//neighbor rules constrain roughly half their neighbors to a random symbol
+		if (r < neighborRuleCount)
+		{
+			rule->bMatchNeighbors = true;
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+				{
+					if (i == 1 && j == 1) continue;
+					if (stream.FRand() < 0.5f)
+						(*rule->matchNeighborsMap)[i][j] = lSystem.symbols[stream.RandRange(0, symbolCount - 1)];
+				}
+			}
+		}
+
+		lSystem.rules.Add(rule);
+	}
+
+	int baseSize = FMath::Max(params.baseSize, 1);
+	LSymbol2DMapPtr lod0 = LSymbol::CreateLSymbolMap(baseSize, baseSize);
+	for (int i = 0; i < baseSize; ++i)
+	{
+		for (int j = 0; j < baseSize; ++j)
+		{
+			(*lod0)[i][j] = lSystem.symbols[stream.RandRange(0, symbolCount - 1)];
+		}
+	}
+	lSystem.lSystemLoDs.Add(lod0);
+}
+
+TArray<LSystemBenchmarkResult> LSystemBenchmark::Run(const LSystemBenchmarkParams& params)
+{
+	TArray<LSystemBenchmarkResult> results = TArray<LSystemBenchmarkResult>();
+
+	LSystem lSystem;
+	BuildSyntheticLSystem(lSystem, params);
+
+	for (int lod = 1; lod <= params.maxLoD; ++lod)
+	{
+		LSymbol2DMapPtr source = lSystem.lSystemLoDs[lSystem.lSystemLoDs.Num() - 1];
+
+		double startTime = FPlatformTime::Seconds();
+		LSymbol2DMapPtr newLoD = lSystem.IterateLString(source);
+		double endTime = FPlatformTime::Seconds();
+
+		lSystem.lSystemLoDs.Add(newLoD);
+
+		LSystemBenchmarkResult result;
+		result.lod = lod;
+		result.cellsOut = (int64)newLoD->Num() * (*newLoD)[0].Num();
+		result.seconds = endTime - startTime;
+		result.cellsPerSecond = (result.seconds > 0.0) ? result.cellsOut / result.seconds : 0.0;
+		result.mapBlocksPerCell = (double)CountMapBlocks(*newLoD) / result.cellsOut;
+		result.lodMemoryBytes = GetLoDMemory(lSystem.lSystemLoDs);
+		results.Add(result);
+	}
+
+	return results;
+}
+
+void LSystemBenchmark::RunAndLog(const LSystemBenchmarkParams& params)
+{
+	UE_LOG(LogLTerrain, Display, TEXT("LSystem benchmark: %d symbols, %d rules, %.2f neighbor rules, %dx%d base"),
+		params.symbolCount, params.ruleCount, params.neighborRuleFraction, params.baseSize, params.baseSize);
+
+	SIZE_T peakMemory = 0;
+	for (const LSystemBenchmarkResult& result : Run(params))
+	{
+		peakMemory = FMath::Max(peakMemory, result.lodMemoryBytes);
+		UE_LOG(LogLTerrain, Display, TEXT("  LoD %d: %lld cells, %.3f ms, %.0f cells/sec, %.2f map blocks/cell, lSystemLoDs %.2f MB"),
+			result.lod,
+			result.cellsOut,
+			result.seconds * 1000.0,
+			result.cellsPerSecond,
+			result.mapBlocksPerCell,
+			result.lodMemoryBytes / (1024.0 * 1024.0));
+	}
+	UE_LOG(LogLTerrain, Display, TEXT("  peak lSystemLoDs memory: %.2f MB"), peakMemory / (1024.0 * 1024.0));
+}
+
+void LSystemBenchmark::RunPresets()
+{
+	const int symbolCounts[] = { 4, 16, 64 };
+	const int ruleCounts[] = { 4, 32, 128 };
+	const float neighborFractions[] = { 0.f, 0.5f, 1.f };
+
+	for (int symbolCount : symbolCounts)
+	{
+		for (int ruleCount : ruleCounts)
+		{
+			for (float neighborFraction : neighborFractions)
+			{
+				LSystemBenchmarkParams params = LSystemBenchmarkParams();
+				params.symbolCount = symbolCount;
+				params.ruleCount = ruleCount;
+				params.neighborRuleFraction = neighborFraction;
+				RunAndLog(params);
+			}
+		}
+	}
+}
+
+//heap blocks a map's arrays hold, the outer array and one per allocated row
+int64 LSystemBenchmark::CountMapBlocks(const LSymbol2DMap& map)
+{
+	int64 count = (map.Max() > 0) ? 1 : 0;
+	for (const TArray<LSymbolPtr>& row : map)
+	{
+		if (row.Max() > 0) ++count;
+	}
+	return count;
+}
+
+//bytes owned by the LoD maps themselves; symbols are shared with the LSystem and not counted
+SIZE_T LSystemBenchmark::GetLoDMemory(const TArray<LSymbol2DMapPtr>& lods)
+{
+	SIZE_T total = lods.GetAllocatedSize();
+	for (const LSymbol2DMapPtr& lod : lods)
+	{
+		if (!lod.IsValid()) continue;
+
+		total += sizeof(LSymbol2DMap) + lod->GetAllocatedSize();
+		for (const TArray<LSymbolPtr>& row : *lod)
+		{
+			total += row.GetAllocatedSize();
+		}
+	}
+	return total;
+}
+
+static void BenchmarkLSystemCommand(const TArray<FString>& args)
+{
+	if (args.Num() == 0)
+	{
+		LSystemBenchmark::RunPresets();
+		return;
+	}
+
+	LSystemBenchmarkParams params = LSystemBenchmarkParams();
+	if (args.Num() > 0) params.symbolCount = FCString::Atoi(*args[0]);
+	if (args.Num() > 1) params.ruleCount = FCString::Atoi(*args[1]);
+	if (args.Num() > 2) params.neighborRuleFraction = FCString::Atof(*args[2]);
+	if (args.Num() > 3) params.maxLoD = FCString::Atoi(*args[3]);
+	LSystemBenchmark::RunAndLog(params);
+}
+
+static FAutoConsoleCommand BenchmarkLSystemCmd(
+	TEXT("LTerrain.BenchmarkLSystem"),
+	TEXT("Times IterateLString on synthetic LSystems. Args: [symbols] [rules] [neighborFraction] [maxLoD]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLSystemCommand));
@@ -3,139 +3,393 @@
 
 #include "LandscapeComponent.h"
 
+//claims seam segments, then tiles until none are left inside the admitted components
+//work is claimed in order from one shared counter, so an idle worker always takes the oldest unclaimed work
+//whichever component it is in, and one slow component never holds up the rest
 void FLTerrainComponentMainTask::DoWork()
 {
-	ULandscapeComponent* landscapeComponent = SP.terrain->LandscapeComponents[compIdx];
+	//weightmaps are built a tile row at a time from the blends recorded in the main loop
+	//scratch comes from the context, workers come and go with the admitted tiles but their scratch stays warm
+	//wide enough for a whole seam row, tiles only use the start of it
+	LWeightRowScratch& weightScratch = *SP.context->AcquireScratch(SP.ComponentSizeVerts, SP.layerCount);
 
-	//init height data
-	TArray<FColor>& hmapdata = SP.heightMaps[compIdx];
-	hmapdata.Reserve(FMath::Square(SP.ComponentSizeVerts));
+	const int32 seamCount = SP.seamSegments.Num();
+	const int32 tileCount = seamCount + SP.componentOrder.Num() * SP.tilesPerComponent;
+	for (;;)
+	{
+		int32 tileIdx = SP.nextTile;
+		if (tileIdx >= tileCount) break;
+		//a worker finding seams still being generated exits, the one finishing the last seam carries on into the tiles
+		if (tileIdx >= seamCount && (SP.seamsRemaining.GetValue() > 0 || (tileIdx - seamCount) / SP.tilesPerComponent >= SP.admittedComponents.GetValue())) break;
+		if (FPlatformAtomics::InterlockedCompareExchange(&SP.nextTile, tileIdx + 1, tileIdx) != tileIdx) continue;
+
+		//after a cancel work is still claimed so every admitted component reports back, but nothing is computed
+		if (tileIdx < seamCount)
+		{
+			if (!SP.bCancelled) GenerateSeam(SP, tileIdx, weightScratch);
+			SP.seamsRemaining.Decrement();
+			continue;
+		}
+
+		int32 componentTileIdx = tileIdx - seamCount;
+		int32 orderIdx = componentTileIdx / SP.tilesPerComponent;
+		int32 compIdx = SP.componentOrder[orderIdx];
+		FIntRect tile = LTerrainGeneration::GetTileVerts(SP, componentTileIdx % SP.tilesPerComponent);
+		if (!SP.bCancelled)
+		{
+			//vertices shared with a neighbor were computed once as seams, only the rest is generated here
+			FIntRect interior = LTerrainGeneration::GetTileInterior(SP, compIdx, tile);
+			if (interior.Width() > 0 && interior.Height() > 0)
+			{
+				LTileTarget target = GetComponentTarget(SP, compIdx, interior);
+				FIntRect verts = LTerrainGeneration::GetGlobalVerts(SP, compIdx, interior);
+
+				//tiles inside a single source patch skip blending entirely, mixed components still have uniform tiles
+				int32 uniformPatchIdx = SP.componentUniformPatchIdxs[orderIdx];
+				if (uniformPatchIdx == INDEX_NONE)
+					uniformPatchIdx = LTerrainGeneration::GetUniformPatchIdx(SP, LTerrainGeneration::GetTileSourceWindow(SP, compIdx, interior));
+
+				if (uniformPatchIdx != INDEX_NONE)
+					GenerateTileUniform(SP, verts, target, uniformPatchIdx, weightScratch);
+				else
+					SP.tileKernel(SP, verts, target, weightScratch);
+			}
+			CopySeams(SP, compIdx, tile);
+			SP.completedTileRows.Add(tile.Height());
+		}
+
+		//the last tile of a component hands it to the game thread
+		if (SP.componentTilesRemaining[orderIdx].Decrement() == 0)
+			onComponentReady.ExecuteIfBound(compIdx);
+	}
 
-	//init patch blend data to 0
-	TArray<TArray<float>>& patchBlendData = SP.patchBlendData[compIdx];
-	patchBlendData.Init(TArray<float>(), SP.lSystem->patches.Num());
-	for (int i = 0; i < SP.lSystem->patches.Num(); ++i)
+	SP.context->ReleaseScratch(&weightScratch);
+	SP.activeWorkers.Decrement();
+}
+
+//picks the tile kernel for this run from settings that cannot change while it generates
+//anything not covered by a specialization uses the generic kernel
+LTileKernel FLTerrainComponentMainTask::SelectTileKernel(const LSharedTaskParams& SP)
+{
+	bool bHeightNoise = false;
+	bool bSingleLayer = SP.layerCount == 1;
+	for (const LCompiledPatch& patch : SP.compiledPatches)
 	{
-		patchBlendData[i].Init(0.f, FMath::Square(SP.ComponentSizeVerts));
+		bHeightNoise |= patch.noiseMaps.Num() > 0;
+		//a lone layer is fully painted wherever it is painted at all, as long as no paint weight depends on noise
+		bSingleLayer &= patch.uniformLayerWeights.Num() == 1;
 	}
 
-	//init weight data to 0
-	TArray<TArray<uint8>>& weightData = SP.weightMaps[compIdx]; //stored as [layer][datapos]
-	weightData.Init(TArray<uint8>(), SP.layerCount);
-	for (int i = 0; i < SP.layerCount; ++i)
+	if (SP.layerCount == 0)
+		return (bHeightNoise) ? &GenerateTileKernel<false, true, false> : &GenerateTileKernel<false, false, false>;
+	if (bSingleLayer)
+		return (bHeightNoise) ? &GenerateTileKernel<true, true, true> : &GenerateTileKernel<true, false, true>;
+	return (bHeightNoise) ? &GenerateTile : &GenerateTileKernel<true, false, false>;
+}
+
+void FLTerrainComponentMainTask::GenerateTile(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, LWeightRowScratch& weightScratch)
+{
+	GenerateTileKernel<true, true, false>(SP, verts, target, weightScratch);
+}
+
+//the component buffers, offset to the first vertex of a component local tile
+LTileTarget FLTerrainComponentMainTask::GetComponentTarget(LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile)
+{
+	const int32 offset = tile.Min.Y * SP.ComponentSizeVerts + tile.Min.X;
+
+	LTileTarget target;
+	target.stride = SP.ComponentSizeVerts;
+	target.heights = SP.heightMaps[compIdx].GetData() + offset;
+	target.blends = SP.patchBlendData[compIdx].GetData() + offset;
+	for (TArray<uint8>& layerWeights : SP.weightMaps[compIdx])
 	{
-		weightData[i].Init(0, FMath::Square(SP.ComponentSizeVerts));
+		target.layers.Add(layerWeights.GetData() + offset);
 	}
+	return target;
+}
+
+//a rectangle of global vertices, written to target with the rectangle's first vertex at index 0
+//each tile row writes short contiguous runs of every output, so the whole tile's working set stays cached
+//bPaint: there are landscape layers, bHeightNoise: some patch has height noise, bSingleLayer: one layer and no paint weight uses noise
+template<bool bPaint, bool bHeightNoise, bool bSingleLayer>
+void FLTerrainComponentMainTask::GenerateTileKernel(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, LWeightRowScratch& weightScratch)
+{
+	//every vertex reads its source cells, weights and noise coordinates from the sampling plan
+	const LSamplingAxis& sampleX = SP.samplingX;
+	const LSamplingAxis& sampleY = SP.samplingY;
+
+	if (bPaint && !bSingleLayer) weightScratch.SetRowLength(verts.Width());
 
 	///BEGIN MAIN LOOP
-	for (int i = 0; i < SP.ComponentSizeVerts; ++i)
+	for (int gy = verts.Min.Y; gy < verts.Max.Y; ++gy)
 	{
-		for (int j = 0; j < SP.ComponentSizeVerts; ++j)
-		{
-			///BUNCH OF GENERAL VARIABLES
-			float xPercCoords = (float)(((compIdx % SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1)) + j) / (float)(SP.landscapeComponentCountSqrt * (SP.ComponentSizeVerts - 1));
-			float yPercCoords = (float)(((compIdx / SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1)) + i) / (float)(SP.landscapeComponentCountSqrt * (SP.ComponentSizeVerts - 1));
-			float xFloatCoords = xPercCoords * SP.sourceSizeX;
-			float yFloatCoords = yPercCoords * SP.sourceSizeY;
+		//cooperative cancellation, checked once a row
+		if (SP.bCancelled) break;
 
-			LPatchPtr curPatch = *(SP.symbolPatchMap.Find(LSystem::GetMapSymbolFrom01Coords(SP.sourceLSymbolMap, xPercCoords, yPercCoords)));
-			SP.AddUniqueToUsedPatches(curPatch);
+		//everything along y is constant for the row
+		const int32 rowOffset0 = sampleY.cell0[gy] * SP.sourceSizeX;
+		const int32 rowOffset1 = sampleY.cell1[gy] * SP.sourceSizeX;
+		const float bilerpY = sampleY.ease[gy];
+		const float scaledY = sampleY.noiseCoord[gy];
+		const int32* patchRow0 = SP.sourcePatchIdxs.GetData() + rowOffset0;
+		const int32* patchRow1 = SP.sourcePatchIdxs.GetData() + rowOffset1;
+		const int32 outRow = (gy - verts.Min.Y) * target.stride;
 
-			//get 4 indices of source patches surrounding current vert
-			int xFloorCoords = FMath::FloorToInt(xFloatCoords - 0.5f);
-			int yFloorCoords = FMath::FloorToInt(yFloatCoords - 0.5f);
-			int xFloorCoordsp1 = FMath::Min(xFloorCoords + 1, SP.sourceSizeX - 1);
-			int yFloorCoordsp1 = FMath::Min(yFloorCoords + 1, SP.sourceSizeY - 1);
-			xFloorCoords = FMath::Max(xFloorCoords, 0);
-			yFloorCoords = FMath::Max(yFloorCoords, 0);
+		//large scale heights for the whole row, through the run's interpolation policy
+		LTerrainGeneration::InterpolateHeightRow(SP, weightScratch, verts.Min.X, verts.Width(), gy);
+		const float* heightRow = weightScratch.heightRow.GetData() - verts.Min.X;
 
-			float scaledX = ((compIdx % SP.landscapeComponentCountSqrt)*(SP.ComponentSizeVerts - 1) + j)*0.1f;
-			float scaledY = ((compIdx / SP.landscapeComponentCountSqrt)*(SP.ComponentSizeVerts - 1) + i)*0.1f;
+		for (int gx = verts.Min.X; gx < verts.Max.X; ++gx)
+		{
+			///BUNCH OF GENERAL VARIABLES
+			const int32 outIdx = outRow + gx - verts.Min.X;
+			const int32 xFloorCoords = sampleX.cell0[gx];
+			const int32 xFloorCoordsp1 = sampleX.cell1[gx];
+			const float bilerpX = sampleX.ease[gx];
+			const float scaledX = sampleX.noiseCoord[gx];
 
 			//four neighboring patches to vertex
-			LPatchPtr patchx0y0 = (*SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[yFloorCoords][xFloorCoords]));
-			LPatchPtr patchx1y0 = (*SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[yFloorCoords][xFloorCoordsp1]));
-			LPatchPtr patchx0y1 = (*SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[yFloorCoordsp1][xFloorCoords]));
-			LPatchPtr patchx1y1 = (*SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[yFloorCoordsp1][xFloorCoordsp1]));
-
-			TArray<int> patchIdxsTouched = TArray<int>();
-
-			//bilerp fractional coordinates
-			float bilerpX = LTerrainGeneration::BilerpEase(FMath::Frac(xFloatCoords + 0.5f));
-			float bilerpY = LTerrainGeneration::BilerpEase(FMath::Frac(yFloatCoords + 0.5f));
+			int ix0y0 = patchRow0[xFloorCoords];
+			int ix1y0 = patchRow0[xFloorCoordsp1];
+			int ix0y1 = patchRow1[xFloorCoords];
+			int ix1y1 = patchRow1[xFloorCoordsp1];
 			///END OF GENERAL VARIABLES
 
 			///CREATE TILE BLEND WEIGHT MAP
-			int ix0y0 = 0, ix1y0 = 0, ix0y1 = 0, ix1y1 = 0;
-			SP.lSystem->patches.Find(patchx0y0, ix0y0);
-			patchBlendData[ix0y0][i*SP.ComponentSizeVerts + j] += (1 - bilerpX)*(1 - bilerpY);
-			patchIdxsTouched.AddUnique(ix0y0);
-
-			SP.lSystem->patches.Find(patchx1y0, ix1y0);
-			patchBlendData[ix1y0][i*SP.ComponentSizeVerts + j] += (bilerpX)*(1 - bilerpY);
-			patchIdxsTouched.AddUnique(ix1y0);
-
-			SP.lSystem->patches.Find(patchx0y1, ix0y1);
-			patchBlendData[ix0y1][i*SP.ComponentSizeVerts + j] += (1 - bilerpX)*(bilerpY);
-			patchIdxsTouched.AddUnique(ix0y1);
-
-			SP.lSystem->patches.Find(patchx1y1, ix1y1);
-			patchBlendData[ix1y1][i*SP.ComponentSizeVerts + j] += (bilerpX)*(bilerpY);
-			patchIdxsTouched.AddUnique(ix1y1);
+			//unique patches touched by this vertex and their full precision weights
+			int patchIdxsTouched[LPatchBlend::MaxPatches];
+			float patchWeights[LPatchBlend::MaxPatches];
+			int patchTouchedCount = 0;
+			auto AddPatchWeight = [&](int patchIdx, float weight) {
+				for (int k = 0; k < patchTouchedCount; ++k)
+				{
+					if (patchIdxsTouched[k] == patchIdx)
+					{
+						patchWeights[k] += weight;
+						return;
+					}
+				}
+				patchIdxsTouched[patchTouchedCount] = patchIdx;
+				patchWeights[patchTouchedCount] = weight;
+				++patchTouchedCount;
+			};
+
+			AddPatchWeight(ix0y0, (1 - bilerpX)*(1 - bilerpY));
+			AddPatchWeight(ix1y0, (bilerpX)*(1 - bilerpY));
+			AddPatchWeight(ix0y1, (1 - bilerpX)*(bilerpY));
+			AddPatchWeight(ix1y1, (bilerpX)*(bilerpY));
+
+			target.blends[outIdx] = LPatchBlend::Quantize(patchIdxsTouched, patchWeights, patchTouchedCount);
 			///END TILE BLEND WEIGHT MAP
 
 			///HEIGHT MAP DATA
-			//generate large scale height value
-			uint16 heightval = (int)FMath::BiLerp(
-				(float)SP.smoothedHeightMap[yFloorCoords   * SP.sourceSizeX + xFloorCoords],
-				(float)SP.smoothedHeightMap[yFloorCoords   * SP.sourceSizeX + xFloorCoordsp1],
-				(float)SP.smoothedHeightMap[yFloorCoordsp1 * SP.sourceSizeX + xFloorCoords],
-				(float)SP.smoothedHeightMap[yFloorCoordsp1 * SP.sourceSizeX + xFloorCoordsp1],
-				bilerpX,
-				bilerpY
-			);
+			//large scale height value
+			uint16 heightval = (int)heightRow[gx];
 
 			//noise amount
-			float noiseTotal = 0.f;
-			for (int patchIdx : patchIdxsTouched)
+			if (bHeightNoise)
 			{
-				noiseTotal +=
-					patchBlendData[patchIdx][i*SP.ComponentSizeVerts + j] *
-					LTerrainGeneration::SumNoiseMaps(SP.lSystem->patches[patchIdx]->noiseMaps, scaledX, scaledY);
+				float noiseTotal = 0.f;
+				for (int k = 0; k < patchTouchedCount; ++k)
+				{
+					noiseTotal +=
+						patchWeights[k] *
+						LTerrainGeneration::SumNoiseMaps(SP.compiledPatches[patchIdxsTouched[k]].noiseMaps, scaledX, scaledY);
+				}
+				heightval += (int)(SP.metersToU16 * noiseTotal);
 			}
-			heightval += (int)(SP.metersToU16 * noiseTotal);
 
-			//data stored in RGBA 32 bit format, RG is 16 bit heightmap data
-			hmapdata.Add(FColor(heightval >> 8, heightval & 0xFF, 0));
+			target.heights[outIdx] = heightval;
 			///END HEIGHT MAP DATA
 
 			///TEXTURE WEIGHT MAP DATA
-			if (SP.layerCount != 0)
+			if (bSingleLayer)
 			{
-				TArray<int> textureIdxsTouched;
-				TArray<float> summedWeights = TArray<float>();
-				summedWeights.Init(0.f, SP.lSystem->groundTextures.Num());
-
-				for (int patchIdx : patchIdxsTouched)
+				//renormalized, the layer is at full weight if any patch blended into the vertex paints it
+				uint8 layerWeight = 0;
+				for (int k = 0; k < patchTouchedCount; ++k)
 				{
-					TArray<float> weights;
-					LTerrainGeneration::GetWeightMapsAt(*SP.lSystem, SP.lSystem->patches[patchIdx]->paintWeights, scaledX, scaledY, weights, textureIdxsTouched);
-					for (int texIdx : textureIdxsTouched)
-					{
-						summedWeights[texIdx] += weights[texIdx] * patchBlendData[patchIdx][i*SP.ComponentSizeVerts + j];
-					}
+					if (patchWeights[k] > 0.f)
+						layerWeight = FMath::Max(layerWeight, SP.compiledPatches[patchIdxsTouched[k]].uniformLayerWeights[0]);
 				}
+				target.layers[0][outIdx] = layerWeight;
+			}
+			else if (bPaint)
+			{
+				weightScratch.SetVertexBlend(gx - verts.Min.X, patchIdxsTouched, patchWeights, patchTouchedCount);
+			}
+			///END TEXTURE WEIGHT MAP DATA
+		}
+
+		if (bPaint && !bSingleLayer)
+			LTerrainGeneration::GetWeightMapRow(SP, weightScratch, sampleX.noiseCoord[verts.Min.X], 0.1f, scaledY, target.layers.GetData(), outRow);
+	}
+}
+
+//GenerateTile for tiles where all four source cells of every vertex use the same patch
+//the blend is the same everywhere, only one noise stack is summed and constant layer weights are filled directly
+void FLTerrainComponentMainTask::GenerateTileUniform(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, int32 patchIdx, LWeightRowScratch& weightScratch)
+{
+	const LCompiledPatch& patch = SP.compiledPatches[patchIdx];
+	const float fullWeight = 1.f;
+	const LPatchBlend blend = LPatchBlend::Quantize(&patchIdx, &fullWeight, 1);
+	const bool bDirectWeights = patch.uniformLayerWeights.Num() == SP.layerCount;
+
+	if (SP.layerCount != 0 && !bDirectWeights)
+	{
+		weightScratch.SetRowLength(verts.Width());
+		for (int j = 0; j < verts.Width(); ++j)
+		{
+			weightScratch.SetVertexBlend(j, &patchIdx, &fullWeight, 1);
+		}
+	}
+
+	const LSamplingAxis& sampleX = SP.samplingX;
+	const LSamplingAxis& sampleY = SP.samplingY;
+
+	for (int gy = verts.Min.Y; gy < verts.Max.Y; ++gy)
+	{
+		//cooperative cancellation, checked once a row
+		if (SP.bCancelled) break;
+
+		const float scaledY = sampleY.noiseCoord[gy];
+		const int32 outRow = (gy - verts.Min.Y) * target.stride;
 
-				for (int texIdx : textureIdxsTouched)
+		LTerrainGeneration::InterpolateHeightRow(SP, weightScratch, verts.Min.X, verts.Width(), gy);
+		const float* heightRow = weightScratch.heightRow.GetData() - verts.Min.X;
+
+		for (int gx = verts.Min.X; gx < verts.Max.X; ++gx)
+		{
+			const int32 outIdx = outRow + gx - verts.Min.X;
+
+			target.blends[outIdx] = blend;
+
+			uint16 heightval = (int)heightRow[gx];
+			heightval += (int)(SP.metersToU16 * LTerrainGeneration::SumNoiseMaps(patch.noiseMaps, sampleX.noiseCoord[gx], scaledY));
+
+			target.heights[outIdx] = heightval;
+		}
+
+		if (SP.layerCount != 0)
+		{
+			if (bDirectWeights)
+			{
+				for (int32 layerIdx = 0; layerIdx < SP.layerCount; ++layerIdx)
 				{
-					weightData[texIdx][i*SP.ComponentSizeVerts + j] =
-						FMath::Clamp<uint8>(summedWeights[texIdx] * 255, 0, 255);
+					FMemory::Memset(target.layers[layerIdx] + outRow, patch.uniformLayerWeights[layerIdx], verts.Width());
 				}
 			}
-			///END TEXTURE WEIGHT MAP DATA
+			else
+			{
+				LTerrainGeneration::GetWeightMapRow(SP, weightScratch, sampleX.noiseCoord[verts.Min.X], 0.1f, scaledY, target.layers.GetData(), outRow);
+			}
 		}
 	}
-	onCompletion.ExecuteIfBound(true); //succeeded in process
 }
 
+//finds the border segments shared by neighboring components next to a dirty component and sizes their buffers
+//the segments themselves are generated by the workers, as the first work items claimed through nextTile
+void FLTerrainComponentMainTask::PrepareSeams(LSharedTaskParams& SP)
+{
+	const int32 countSqrt = SP.landscapeComponentCountSqrt;
+	const int32 seamCount = (countSqrt - 1) * countSqrt;
+	SP.verticalSeams.Reset();
+	SP.verticalSeams.SetNum(FMath::Max(seamCount, 0));
+	SP.horizontalSeams.Reset();
+	SP.horizontalSeams.SetNum(FMath::Max(seamCount, 0));
+	SP.seamSegments.Reset();
+	SP.seamsRemaining.Reset();
+	if (seamCount <= 0) return;
+
+	//seam k lies between component columns (or rows) k and k+1, indexed [k * countSqrt + position along the seam]
+	//X is 1 for vertical seams, Y is the seam index
+	for (int32 seamIdx = 0; seamIdx < seamCount; ++seamIdx)
+	{
+		int32 k = seamIdx / countSqrt;
+		int32 along = seamIdx % countSqrt;
+		if (SP.dirtyComponents[along * countSqrt + k] || SP.dirtyComponents[along * countSqrt + k + 1])
+			SP.seamSegments.Add(FIntPoint(1, seamIdx));
+		if (SP.dirtyComponents[k * countSqrt + along] || SP.dirtyComponents[(k + 1) * countSqrt + along])
+			SP.seamSegments.Add(FIntPoint(0, seamIdx));
+	}
+
+	for (const FIntPoint& seamSegment : SP.seamSegments)
+	{
+		LSeamSegment& segment = (seamSegment.X == 1) ? SP.verticalSeams[seamSegment.Y] : SP.horizontalSeams[seamSegment.Y];
+		segment.heights.SetNumUninitialized(SP.ComponentSizeVerts);
+		segment.blends.SetNumUninitialized(SP.ComponentSizeVerts);
+		segment.weights.SetNumUninitialized(SP.ComponentSizeVerts * SP.layerCount);
+	}
+	SP.seamsRemaining.Set(SP.seamSegments.Num());
+}
+
+//one seam segment, always run through the run's tile kernel so a vertex on two segments (a corner) gets the same value from both
+void FLTerrainComponentMainTask::GenerateSeam(LSharedTaskParams& SP, int32 segmentIdx, LWeightRowScratch& weightScratch)
+{
+	const int32 countSqrt = SP.landscapeComponentCountSqrt;
+	const int32 quads = SP.ComponentSizeVerts - 1;
+	const bool bVertical = SP.seamSegments[segmentIdx].X == 1;
+	const int32 seamIdx = SP.seamSegments[segmentIdx].Y;
+	const int32 lineVert = (seamIdx / countSqrt + 1) * quads;
+	const int32 firstVert = (seamIdx % countSqrt) * quads;
+
+	LSeamSegment& segment = (bVertical) ? SP.verticalSeams[seamIdx] : SP.horizontalSeams[seamIdx];
+	LTileTarget target;
+	target.stride = (bVertical) ? 1 : SP.ComponentSizeVerts;
+	target.heights = segment.heights.GetData();
+	target.blends = segment.blends.GetData();
+	for (int32 layerIdx = 0; layerIdx < SP.layerCount; ++layerIdx)
+	{
+		target.layers.Add(segment.weights.GetData() + layerIdx * SP.ComponentSizeVerts);
+	}
 
+	FIntRect verts = (bVertical) ?
+		FIntRect(lineVert, firstVert, lineVert + 1, firstVert + SP.ComponentSizeVerts) :
+		FIntRect(firstVert, lineVert, firstVert + SP.ComponentSizeVerts, lineVert + 1);
+	SP.tileKernel(SP, verts, target, weightScratch);
+}
+
+//fills the parts of a tile on a shared component edge from the precomputed seams
+//rows go first so corners, which are on both, always come from the vertical seam
+void FLTerrainComponentMainTask::CopySeams(LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile)
+{
+	const int32 countSqrt = SP.landscapeComponentCountSqrt;
+	const int32 compX = compIdx % countSqrt;
+	const int32 compY = compIdx / countSqrt;
+	const int32 last = SP.ComponentSizeVerts - 1;
+	TArray<uint16>& heights = SP.heightMaps[compIdx];
+	TArray<LPatchBlend>& blends = SP.patchBlendData[compIdx];
+	TArray<TArray<uint8>>& weights = SP.weightMaps[compIdx];
+
+	auto CopyRow = [&](const LSeamSegment& segment, int32 row) {
+		const int32 count = tile.Width();
+		const int32 dst = row * SP.ComponentSizeVerts + tile.Min.X;
+		FMemory::Memcpy(heights.GetData() + dst, segment.heights.GetData() + tile.Min.X, count * sizeof(uint16));
+		FMemory::Memcpy(blends.GetData() + dst, segment.blends.GetData() + tile.Min.X, count * sizeof(LPatchBlend));
+		for (int32 layerIdx = 0; layerIdx < SP.layerCount; ++layerIdx)
+		{
+			FMemory::Memcpy(weights[layerIdx].GetData() + dst, segment.weights.GetData() + layerIdx * SP.ComponentSizeVerts + tile.Min.X, count);
+		}
+	};
+	auto CopyColumn = [&](const LSeamSegment& segment, int32 column) {
+		for (int32 i = tile.Min.Y; i < tile.Max.Y; ++i)
+		{
+			const int32 dst = i * SP.ComponentSizeVerts + column;
+			heights[dst] = segment.heights[i];
+			blends[dst] = segment.blends[i];
+			for (int32 layerIdx = 0; layerIdx < SP.layerCount; ++layerIdx)
+			{
+				weights[layerIdx][dst] = segment.weights[layerIdx * SP.ComponentSizeVerts + i];
+			}
+		}
+	};
+
+	if (compY > 0 && tile.Min.Y == 0)
+		CopyRow(SP.horizontalSeams[(compY - 1) * countSqrt + compX], 0);
+	if (compY < countSqrt - 1 && tile.Max.Y == SP.ComponentSizeVerts)
+		CopyRow(SP.horizontalSeams[compY * countSqrt + compX], last);
+	if (compX > 0 && tile.Min.X == 0)
+		CopyColumn(SP.verticalSeams[(compX - 1) * countSqrt + compY], 0);
+	if (compX < countSqrt - 1 && tile.Max.X == SP.ComponentSizeVerts)
+		CopyColumn(SP.verticalSeams[compX * countSqrt + compY], last);
+}
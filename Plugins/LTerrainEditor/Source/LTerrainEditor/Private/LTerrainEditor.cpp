@@ -10,11 +10,15 @@
 #include "LTileEditor.h"
 #include "LPatchEditor.h"
 #include "LGenOptions.h"
+#include "LTerrainGeneration.h"
+#include "LGenerationQueue.h"
 
 #include "LevelEditor.h"
 #include "SharedPointer.h"
 
 
+DEFINE_LOG_CATEGORY(LogLTerrain);
+
 static const FName MapEditorTabName("LMapEditor");
 static const FName RuleEditorTabName("LRuleEditor");
 static const FName TileEditorTabName("LTileEditor");
@@ -78,12 +82,22 @@ void FLTerrainEditorModule::StartupModule()
 	lSystem = LSystem();
 
 	lSystem.Reset();
+
+	generationCache = MakeShareable(new LGenerationCache());
+	generationQueue = MakeShareable(new LGenerationQueue());
+	generationQueue->SetPoolSize(lSystem.genSettings.workerThreadCount);
 }
 
 void FLTerrainEditorModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	if (generationQueue.IsValid())
+	{
+		generationQueue->Shutdown();
+		generationQueue.Reset();
+	}
+
 	FGlobalTabmanager::Get()->UnregisterTabSpawner(MapEditorTabName);
 	FGlobalTabmanager::Get()->UnregisterTabSpawner(RuleEditorTabName);
 	FGlobalTabmanager::Get()->UnregisterTabSpawner(TileEditorTabName);
@@ -1,263 +1,918 @@
 #include "LTerrainEditor.h"
 #include "LTerrainGeneration.h"
 
-#include "LTerrainComponentMainTask.h"
-#include "LFoliageTask.h"
+#include "LGenerationJob.h"
+#include "LRandom.h"
+
+#include "Async/ParallelFor.h"
 
 #include "LandscapeComponent.h"
 #include "LandscapeEdit.h"
 #include "Landscape.h"
 #include "LandscapeInfo.h"
 #include "LandscapeLayerInfoObject.h"
-#include "Materials/MaterialInstanceConstant.h"
 
-#define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
+const FGuid LGenerationCache::FoliageGuid = FGuid(0x4C546572, 0x7261696E, 0x466F6C69, 0x61676530);
+
+//queues a generation as a background job, superseding queued or running generations it covers
+TSharedPtr<LGenerationJob> LTerrainGeneration::GenerateTerrain(LSystem& lSystem, ALandscape* terrain, LGenerationCache& cache, const FIntRect* componentRegion)
+{
+	TSharedPtr<LGenerationJob> job = MakeShareable(new LGenerationJob(lSystem, terrain, cache, componentRegion));
+	FLTerrainEditorModule::GetModule()->generationQueue->Enqueue(job);
+	return job;
+}
 
-void LTerrainGeneration::GenerateTerrain(LSystem& lSystem, ALandscape* terrain)
+//everything up to finding the dirty components, run synchronously before the job starts
+bool LTerrainGeneration::PrepareGeneration(LSharedTaskParams& SP, LSystem& lSystem, ALandscape* terrain, const LGenerationCache& cache, const FIntRect* componentRegion)
 {
-	LSharedTaskParams SP;
+	if (!PrepareSourceTables(SP, lSystem, terrain)) return false;
+
+	//everything else is still computed for the whole landscape, so blending inside the region sees its real neighbors
+	SP.region = FIntRect(0, 0, SP.landscapeComponentCountSqrt, SP.landscapeComponentCountSqrt);
+	if (componentRegion != nullptr)
+	{
+		SP.region.Clip(*componentRegion);
+		if (SP.region.Area() <= 0) return false;
+	}
+	SP.regionBorderFeather = lSystem.genSettings.regionBorderFeather;
+
+	SP.heightMaps.Init(TArray<uint16>(), SP.landscapeComponentCount);
+	SP.weightMaps.Init(TArray<TArray<uint8>>(), SP.landscapeComponentCount);
+	SP.patchBlendData.Init(TArray<LPatchBlend>(), SP.landscapeComponentCount);
+
+	//painting layer data
+	SP.layerCount = lSystem.groundTextures.Num();
+	SP.layerInfos = TArray<ULandscapeLayerInfoObject*>();
+	for (int i = 0; i < SP.layerCount; ++i)
+	{
+		ULandscapeLayerInfoObject* texLayerInfo = Cast<ULandscapeLayerInfoObject>(lSystem.groundTextures[i]->layerInfo.GetAsset());
+		SP.layerInfos.Add(texLayerInfo);
+		SP.layerInfos[SP.layerInfos.Num() - 1]->LayerName = FName(*FString::Printf(TEXT("Layer_%d"), i));
+	}
+
+	//initial rough heightmap, smoothed before the finer detail step
+	SP.context->sourceHeights.Acquire(SP.roughHeightmap, SP.sourceSizeX*SP.sourceSizeY);
+	BuildRoughHeightmap(SP, SP.seed, SP.roughHeightmap);
+	SmoothHeightmap(SP, lSystem.genSettings, SP.roughHeightmap, SP.smoothedHeightMap);
+	SP.context->sourceHeights.Release(SP.roughHeightmap);
+	BuildSamplingPlan(SP);
+
+	//find which components changed since the last generation on this landscape
+	HashComponents(SP, cache, lSystem.genSettings.bIncremental && cache.terrain.Get() == terrain);
+	return SP.dirtyComponentCount > 0;
+}
 
+//the part of preparation that only depends on the landscape's size and the source map, not on the seed or the landscape's current state
+bool LTerrainGeneration::PrepareSourceTables(LSharedTaskParams& SP, LSystem& lSystem, ALandscape* terrain)
+{
 	SP.terrain = terrain;
 	SP.lSystem = &lSystem;
+	SP.seed = lSystem.genSettings.seed;
 
 	SP.landscapeComponentCount = terrain->LandscapeComponents.Num();
 	SP.landscapeComponentCountSqrt = FMath::Sqrt(SP.landscapeComponentCount);
-	if (SP.landscapeComponentCount == 0 || lSystem.lSystemLoDs.Num() == 0) return;
-
-	SP.heightMaps.Init(TArray<FColor>(), SP.landscapeComponentCount);
-	SP.weightMaps.Init(TArray<TArray<uint8>>(), SP.landscapeComponentCount);
-	SP.patchBlendData.Init(TArray<TArray<float>>(), SP.landscapeComponentCount);
-
-	terrain->Modify();
+	if (SP.landscapeComponentCount == 0 || lSystem.lSystemLoDs.Num() == 0) return false;
 
 	//match patches to symbols in the LSystem
 	SP.sourceLSymbolMap = lSystem.lSystemLoDs[lSystem.lSystemLoDs.Num() - 1];
-	SP.sourceSizeX = (*SP.sourceLSymbolMap).Num();
-	SP.sourceSizeY = (*SP.sourceLSymbolMap)[0].Num();
+	//map is stored [y][x]
+	SP.sourceSizeX = (*SP.sourceLSymbolMap)[0].Num();
+	SP.sourceSizeY = (*SP.sourceLSymbolMap).Num();
 	//ComponentSizeVerts taken from LandscapeEdit.cpp, InitHeightmapData checks size as this squared.
 	SP.ComponentSizeVerts = terrain->LandscapeComponents[0]->NumSubsections * (terrain->LandscapeComponents[0]->SubsectionSizeQuads + 1);
 
-	//generate map for symbols and matching patches
-	SP.symbolPatchMap = TMap<LSymbolPtr, LPatchPtr>();
-	for (LSymbolPtr symbol : lSystem.symbols)
+	//generate dense symbol -> patch index tables, looked up once per source cell instead of per vertex
+	BuildPatchTables(SP);
+
+	//unique patches used in the landscape, taken straight from the source map so the worker threads never have to report them
+	TBitArray<> usedPatchBits = TBitArray<>(false, SP.patches.Num());
+	for (int32 patchIdx : SP.sourcePatchIdxs)
 	{
-		LPatchPtr matchingPatch = lSystem.GetLPatchMatch(symbol);
-		SP.symbolPatchMap.Add(symbol, matchingPatch);
+		usedPatchBits[patchIdx] = true;
 	}
 
-	//after heightmap pass, contains a list of unique patches used in the landscape
-	SP.allUsedPatches = TArray<LPatchPtr>();
-
-	//initial rough heightmap
-	SP.roughHeightmap = TArray<uint16>();
-	SP.roughHeightmap.Reserve(SP.sourceSizeX*SP.sourceSizeY);
-
-	//painting layer data
-	SP.layerCount = lSystem.groundTextures.Num();
-	SP.layerInfos = TArray<ULandscapeLayerInfoObject*>();
-	for (int i = 0; i < SP.layerCount; ++i)
+	SP.usedPatchIdxs.Reset();
+	for (TConstSetBitIterator<> it(usedPatchBits); it; ++it)
 	{
-		ULandscapeLayerInfoObject* texLayerInfo = Cast<ULandscapeLayerInfoObject>(lSystem.groundTextures[i]->layerInfo.GetAsset());
-		SP.layerInfos.Add(texLayerInfo);
-		SP.layerInfos[SP.layerInfos.Num() - 1]->LayerName = FName(*FString::Printf(TEXT("Layer_%d"), i));
+		SP.usedPatchIdxs.Add(it.GetIndex());
 	}
 
 	//some constants to be used in generation
 	SP.metersToU16 = (UINT16_MAX / 2) / 256.f;
 	SP.zeroHeight = UINT16_MAX / 2;
+	return true;
+}
 
-	for (int i = 0; i < SP.sourceSizeY; ++i)
+void LTerrainGeneration::BuildPatchTables(LSharedTaskParams& SP)
+{
+	LSystem& lSystem = *SP.lSystem;
+
+	SP.patches = lSystem.patches;
+	SP.handles.Build(lSystem);
+
+	//source map stored [y][x], converted to ids first so symbols only found on the map have an id too
+	TArray<LSymbolId> sourceSymbolIds;
+	SP.handles.ToIds(*SP.sourceLSymbolMap, sourceSymbolIds);
+	SP.symbolPatchIdxs = SP.handles.symbolPatches;
+
+	//symbols with no matching patch share a single default patch, appended after the lSystem patches
+	int32 defaultPatchIdx = INDEX_NONE;
+	auto GetPatchIdx = [&](LSymbolId symbolId)->int32 {
+		int32& patchIdx = SP.symbolPatchIdxs[symbolId];
+		if (patchIdx == INDEX_NONE)
+		{
+			if (defaultPatchIdx == INDEX_NONE)
+				defaultPatchIdx = SP.patches.Add(LPatchPtr(new LPatch()));
+			patchIdx = defaultPatchIdx;
+		}
+		return patchIdx;
+	};
+
+	for (const LSymbolPtr& symbol : lSystem.symbols)
 	{
-		for (int j = 0; j < SP.sourceSizeX; ++j)
+		GetPatchIdx(SP.handles.GetSymbolId(symbol));
+	}
+
+	SP.sourcePatchIdxs.SetNumUninitialized(SP.sourceSizeX * SP.sourceSizeY);
+	for (int32 cellIdx = 0; cellIdx < SP.sourcePatchIdxs.Num(); ++cellIdx)
+	{
+		SP.sourcePatchIdxs[cellIdx] = GetPatchIdx(sourceSymbolIds[cellIdx]);
+	}
+
+	//every noise map is sampled through a copy reseeded from the project seed
+	SP.runNoiseMaps.Reset(SP.seed);
+
+	SP.compiledPatches.SetNum(SP.patches.Num());
+	for (int32 i = 0; i < SP.patches.Num(); ++i)
+	{
+		LCompiledPatch& compiled = SP.compiledPatches[i];
+		compiled.patch = SP.patches[i].Get();
+		compiled.minHeight = compiled.patch->minHeight;
+		compiled.maxHeight = compiled.patch->maxHeight;
+		compiled.heightSmoothFactor = (compiled.patch->bHeightMatch) ? compiled.patch->heightSmoothFactor : 0.f;
+		compiled.noiseMaps.Reset(SP.patches[i]->noiseMaps.Num());
+		for (const LNoisePtr& noise : SP.patches[i]->noiseMaps)
 		{
-			LPatchPtr curPatch = *SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[i][j]);
-			SP.roughHeightmap.Add(SP.zeroHeight + (int)(FMath::FRandRange(curPatch->minHeight, curPatch->maxHeight) * SP.metersToU16));
+			compiled.noiseMaps.Add(SP.runNoiseMaps.Get(noise));
+		}
+
+		//resolve each paint weight to its layer once, rather than searching groundTextures per vertex
+		compiled.paintWeights.Reset(SP.patches[i]->paintWeights.Num());
+		for (const LPaintWeightPtr& paintWeight : SP.patches[i]->paintWeights)
+		{
+			if (!paintWeight->texture.IsValid()) continue;
+
+			int32 layerIdx = lSystem.groundTextures.Find(paintWeight->texture);
+			if (layerIdx == INDEX_NONE) continue;
+			if (compiled.paintWeights.ContainsByPredicate([layerIdx](const LCompiledPaintWeight& other) { return other.layerIdx == layerIdx; }))
+				continue; //a layer is only painted once per patch
+
+			LCompiledPaintWeight compiledPaint;
+			compiledPaint.layerIdx = layerIdx;
+			compiledPaint.weight = paintWeight->weight;
+			compiledPaint.bUseAboveThreshold = paintWeight->bUseAboveThreshold;
+			compiledPaint.noiseMap = SP.runNoiseMaps.Get(paintWeight->noiseMap);
+			compiledPaint.thresholdLow = paintWeight->threshold - paintWeight->thresholdFeather * 0.5f;
+			//zero feather is a hard step, kept finite so noise == threshold doesn't produce a NaN
+			compiledPaint.invFeather = (paintWeight->thresholdFeather > KINDA_SMALL_NUMBER) ? 1.f / paintWeight->thresholdFeather : 1.e6f;
+			compiled.paintWeights.Add(compiledPaint);
+		}
+
+		//layer weights of a vertex blended only from this patch are constant unless a paint weight uses noise
+		//quantized the same way GetWeightMapRow does, so uniform regions can fill their weightmap rows directly
+		compiled.uniformLayerWeights.Reset();
+		bool bUsesNoise = compiled.paintWeights.ContainsByPredicate([](const LCompiledPaintWeight& paint) { return paint.noiseMap != nullptr; });
+		if (!bUsesNoise)
+		{
+			TArray<float, TInlineAllocator<16>> layerWeights;
+			layerWeights.SetNumZeroed(lSystem.groundTextures.Num());
+			float sum = 0.f;
+			for (const LCompiledPaintWeight& paint : compiled.paintWeights)
+			{
+				layerWeights[paint.layerIdx] += paint.weight;
+				sum += paint.weight;
+			}
+
+			float invSum = 1.f / FMath::Max(sum, KINDA_SMALL_NUMBER);
+			compiled.uniformLayerWeights.SetNumUninitialized(layerWeights.Num());
+			for (int32 layerIdx = 0; layerIdx < layerWeights.Num(); ++layerIdx)
+			{
+				compiled.uniformLayerWeights[layerIdx] = (uint8)FMath::Clamp(FMath::RoundToInt(layerWeights[layerIdx] * invSum * 255.f), 0, 255);
+			}
 		}
 	}
+}
 
-	//smooth rough height map before finer detail step
-	SP.smoothedHeightMap = SP.roughHeightmap;
+void LRunNoiseMaps::Reset(int32 inSeed)
+{
+	seed = inSeed;
+	copies.Reset();
+	copyLookup.Reset();
+}
 
+LNoise* LRunNoiseMaps::Get(const LNoisePtr& noise)
+{
+	if (!noise.IsValid()) return nullptr;
+
+	LNoise** found = copyLookup.Find(noise.Get());
+	if (found != nullptr) return *found;
+
+	int32 runSeed = (int32)LRandom::Hash(seed, ELRandomStage::NoiseSeed, (uint32)noise->GetSeed());
+	LNoise* runNoise = new LNoise(*noise, runSeed);
+	copies.Add(LNoisePtr(runNoise));
+	copyLookup.Add(noise.Get(), runNoise);
+	return runNoise;
+}
+
+//random height of every source cell between its patch's min and max height
+void LTerrainGeneration::BuildRoughHeightmap(const LSharedTaskParams& SP, int32 seed, TArray<uint16>& outHeights)
+{
+	outHeights.SetNumUninitialized(SP.sourceSizeX * SP.sourceSizeY, false);
 	for (int i = 0; i < SP.sourceSizeY; ++i)
 	{
 		for (int j = 0; j < SP.sourceSizeX; ++j)
 		{
-			LPatchPtr curPatch = *SP.symbolPatchMap.Find((*SP.sourceLSymbolMap)[i][j]);
-			if (!curPatch->bHeightMatch) continue;
+			//keyed on the cell, so editing one tile does not change the rough height of any other
+			const LCompiledPatch& curPatch = SP.compiledPatches[SP.sourcePatchIdxs[i*SP.sourceSizeX + j]];
+			float roughHeight = LRandom::FRandRange(curPatch.minHeight, curPatch.maxHeight, seed, ELRandomStage::RoughHeight, j, i);
+			outHeights[i*SP.sourceSizeX + j] = SP.zeroHeight + (int)(roughHeight * SP.metersToU16);
+		}
+	}
+}
+
+//box blurs of the rough heightmap, each pass separable and run with a running window sum so cost does not grow with radius
+//cells on patches with bHeightMatch move towards the blurred height by heightSmoothFactor every iteration, others keep their rough height
+void LTerrainGeneration::SmoothHeightmap(const LSharedTaskParams& SP, const LGenSettings& settings, const TArray<uint16>& roughHeights, TArray<uint16>& outHeights)
+{
+	const int32 width = SP.sourceSizeX;
+	const int32 height = SP.sourceSizeY;
+	const int32 stride = Align(width, 4); //padded so the vertical pass can work on 4 columns at a time
+	const int32 radius = FMath::Max(settings.smoothRadius, 0);
+	const int32 iterations = FMath::Max(settings.smoothIterations, 0);
+	const int32 boxPasses = settings.bSmoothGaussian ? 3 : 1;
+
+	outHeights = roughHeights;
+	if (radius == 0 || iterations == 0) return;
+
+	TArray<float> current;
+	current.SetNumZeroed(stride * height);
+	TArray<float> blurred;
+	blurred.SetNumZeroed(stride * height);
+	TArray<float> temp;
+	temp.SetNumZeroed(stride * height);
+
+	//0 for cells that do not height match
+	TArray<float> smoothFactors;
+	smoothFactors.SetNumZeroed(stride * height);
+
+	for (int32 y = 0; y < height; ++y)
+	{
+		for (int32 x = 0; x < width; ++x)
+		{
+			current[y * stride + x] = roughHeights[y * width + x];
+			smoothFactors[y * stride + x] = SP.compiledPatches[SP.sourcePatchIdxs[y * width + x]].heightSmoothFactor;
+		}
+	}
 
-			int avgCount = 1;
-			float avg = SP.roughHeightmap[i*SP.sourceSizeY + j];
-			for (int ii = -1; ii <= 1; ++ii)
+	//horizontal: average of in-bounds cells in [x - radius, x + radius], one row per job
+	auto HorizontalPass = [&](const TArray<float>& src, TArray<float>& dst) {
+		ParallelFor(height, [&](int32 y) {
+			const float* srcRow = src.GetData() + y * stride;
+			float* dstRow = dst.GetData() + y * stride;
+
+			float sum = 0.f;
+			for (int32 x = 0; x <= FMath::Min(radius, width - 1); ++x)
 			{
-				if (i + ii < 0 || i + ii >= SP.sourceSizeY) continue;
+				sum += srcRow[x];
+			}
 
-				for (int jj = -1; jj <= 1; ++jj)
-				{
-					if (j + jj < 0 || j + jj >= SP.sourceSizeX) continue;
+			for (int32 x = 0; x < width; ++x)
+			{
+				int32 count = FMath::Min(x + radius, width - 1) - FMath::Max(x - radius, 0) + 1;
+				dstRow[x] = sum / count;
 
-					avg += (float)SP.roughHeightmap[(i + ii)*SP.sourceSizeY + (j + jj)];
-					++avgCount;
-				}
+				if (x + radius + 1 < width) sum += srcRow[x + radius + 1];
+				if (x - radius >= 0) sum -= srcRow[x - radius];
+			}
+		});
+	};
+
+	//vertical: same window down each column, 4 columns per vector
+	auto VerticalPass = [&](const TArray<float>& src, TArray<float>& dst) {
+		ParallelFor(stride / 4, [&](int32 block) {
+			const int32 x = block * 4;
+
+			VectorRegister sum = VectorZero();
+			for (int32 y = 0; y <= FMath::Min(radius, height - 1); ++y)
+			{
+				sum = VectorAdd(sum, VectorLoad(src.GetData() + y * stride + x));
 			}
 
-			if (avgCount > 1)
+			for (int32 y = 0; y < height; ++y)
 			{
-				//if we have a useful average, blend towards it
-				SP.smoothedHeightMap[i*SP.sourceSizeY + j] = (int)FMath::Lerp(
-					(float)SP.smoothedHeightMap[i*SP.sourceSizeY + j],
-					avg / avgCount,
-					curPatch->heightSmoothFactor);
+				int32 count = FMath::Min(y + radius, height - 1) - FMath::Max(y - radius, 0) + 1;
+				VectorStore(VectorMultiply(sum, VectorSetFloat1(1.f / count)), dst.GetData() + y * stride + x);
+
+				if (y + radius + 1 < height) sum = VectorAdd(sum, VectorLoad(src.GetData() + (y + radius + 1) * stride + x));
+				if (y - radius >= 0) sum = VectorSubtract(sum, VectorLoad(src.GetData() + (y - radius) * stride + x));
 			}
+		});
+	};
+
+	for (int32 iteration = 0; iteration < iterations; ++iteration)
+	{
+		const TArray<float>* passSource = &current;
+		for (int32 pass = 0; pass < boxPasses; ++pass)
+		{
+			HorizontalPass(*passSource, temp);
+			VerticalPass(temp, blurred);
+			passSource = &blurred;
 		}
+
+		//blend each row towards the blurred heights by its per-cell factor
+		ParallelFor(height, [&](int32 y) {
+			float* curRow = current.GetData() + y * stride;
+			const float* blurRow = blurred.GetData() + y * stride;
+			const float* factorRow = smoothFactors.GetData() + y * stride;
+			for (int32 x = 0; x < stride; x += 4)
+			{
+				VectorRegister cur = VectorLoad(curRow + x);
+				VectorRegister delta = VectorSubtract(VectorLoad(blurRow + x), cur);
+				VectorStore(VectorMultiplyAdd(delta, VectorLoad(factorRow + x), cur), curRow + x);
+			}
+		});
 	}
 
-	///SET UP MAIN LOOP AS ASYNC TASK
-	FScopedSlowTask loadingBarMain(SP.landscapeComponentCount+1, LOCTEXT("InitializeText", "Initializing Landscape Data"));
-	loadingBarMain.MakeDialog();
-	loadingBarMain.EnterProgressFrame();
+	for (int32 y = 0; y < height; ++y)
+	{
+		for (int32 x = 0; x < width; ++x)
+		{
+			outHeights[y * width + x] = (uint16)FMath::Clamp(FMath::RoundToInt(current[y * stride + x]), 0, (int32)UINT16_MAX);
+		}
+	}
+}
+
+//interpolation policies for upsampling smoothedHeightMap, weights for Taps source cells
+//the cells are centered on the vertex: the cell at or before it and the one after, plus one more either side for 4 taps
+struct LLinearInterpolation
+{
+	static const int32 Taps = 2;
+	static FORCEINLINE void GetWeights(float t, float* w)
+	{
+		w[0] = 1.f - t;
+		w[1] = t;
+	}
+};
 
-	FOnCompletion onCompletion = FOnCompletion();
-	FThreadSafeCounter taskRunningCount(0);
-	onCompletion.BindLambda([&taskRunningCount](bool bWasSuccessful) {
-		taskRunningCount.Decrement();
-	});
-	
-	//goes positive X for each +1, then positive Y for a row
-	for (int compIdx = 0; compIdx < SP.landscapeComponentCount; ++compIdx)
+struct LEasedLinearInterpolation
+{
+	static const int32 Taps = 2;
+	static FORCEINLINE void GetWeights(float t, float* w)
+	{
+		LLinearInterpolation::GetWeights(LTerrainGeneration::BilerpEase(t), w);
+	}
+};
+
+struct LCatmullRomInterpolation
+{
+	static const int32 Taps = 4;
+	static FORCEINLINE void GetWeights(float t, float* w)
 	{
-		taskRunningCount.Increment();
-		(new FAutoDeleteAsyncTask<FLTerrainComponentMainTask>(compIdx, SP, onCompletion))->StartBackgroundTask();
+		float t2 = t * t;
+		float t3 = t2 * t;
+		w[0] = 0.5f * (-t3 + 2.f * t2 - t);
+		w[1] = 0.5f * (3.f * t3 - 5.f * t2 + 2.f);
+		w[2] = 0.5f * (-3.f * t3 + 4.f * t2 + t);
+		w[3] = 0.5f * (t3 - t2);
 	}
+};
+
+struct LBSplineInterpolation
+{
+	static const int32 Taps = 4;
+	static FORCEINLINE void GetWeights(float t, float* w)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		float it = 1.f - t;
+		w[0] = it * it * it / 6.f;
+		w[1] = (3.f * t3 - 6.f * t2 + 4.f) / 6.f;
+		w[2] = (-3.f * t3 + 3.f * t2 + 3.f * t + 1.f) / 6.f;
+		w[3] = t3 / 6.f;
+	}
+};
+
+template<typename Policy>
+static void BuildHeightTaps(LSamplingAxis& axis, int32 uniqueVerts, int32 sourceSize)
+{
+	axis.heightTapCount = Policy::Taps;
+	axis.heightTaps.SetNumUninitialized(Policy::Taps * axis.vertCount);
+	axis.heightWeights.SetNumUninitialized(Policy::Taps * axis.vertCount);
+
+	for (int32 v = 0; v < axis.vertCount; ++v)
+	{
+		float floatCoords = (float)v / (float)uniqueVerts * sourceSize;
+		int firstCell = FMath::FloorToInt(floatCoords - 0.5f) - (Policy::Taps / 2 - 1);
+
+		float weights[Policy::Taps];
+		Policy::GetWeights(FMath::Frac(floatCoords + 0.5f), weights);
+		for (int32 k = 0; k < Policy::Taps; ++k)
+		{
+			axis.heightTaps[k * axis.vertCount + v] = FMath::Clamp(firstCell + k, 0, sourceSize - 1);
+			axis.heightWeights[k * axis.vertCount + v] = weights[k];
+		}
+	}
+}
+
+void LSamplingAxis::Build(int32 uniqueVerts, int32 sourceSize, ELHeightInterpolation interpolation)
+{
+	vertCount = uniqueVerts + 1;
+	cell0.SetNumUninitialized(vertCount);
+	cell1.SetNumUninitialized(vertCount);
+	ease.SetNumUninitialized(vertCount);
+	noiseCoord.SetNumUninitialized(vertCount);
+
+	for (int32 v = 0; v < vertCount; ++v)
+	{
+		float floatCoords = (float)v / (float)uniqueVerts * sourceSize;
+		int floorCoords = FMath::FloorToInt(floatCoords - 0.5f);
+		cell0[v] = FMath::Max(floorCoords, 0);
+		cell1[v] = FMath::Min(floorCoords + 1, sourceSize - 1);
+		ease[v] = LTerrainGeneration::BilerpEase(FMath::Frac(floatCoords + 0.5f));
+		noiseCoord[v] = v*0.1f;
+	}
+
+	switch (interpolation)
+	{
+	case ELHeightInterpolation::Linear: BuildHeightTaps<LLinearInterpolation>(*this, uniqueVerts, sourceSize); break;
+	case ELHeightInterpolation::CatmullRom: BuildHeightTaps<LCatmullRomInterpolation>(*this, uniqueVerts, sourceSize); break;
+	case ELHeightInterpolation::BSpline: BuildHeightTaps<LBSplineInterpolation>(*this, uniqueVerts, sourceSize); break;
+	default: BuildHeightTaps<LEasedLinearInterpolation>(*this, uniqueVerts, sourceSize); break;
+	}
+}
+
+//per-axis source indices, bilerp weights and noise coordinates for every vertex of the landscape, independent of the seed
+void LTerrainGeneration::BuildSamplingAxes(LSharedTaskParams& SP)
+{
+	int32 uniqueVerts = SP.landscapeComponentCountSqrt * (SP.ComponentSizeVerts - 1);
+	ELHeightInterpolation interpolation = SP.lSystem->genSettings.heightInterpolation;
+	SP.samplingX.Build(uniqueVerts, SP.sourceSizeX, interpolation);
+	SP.samplingY.Build(uniqueVerts, SP.sourceSizeY, interpolation);
+}
+
+//the sampling axes plus the smoothed heights, copied to floats for the height row kernels
+void LTerrainGeneration::BuildSamplingPlan(LSharedTaskParams& SP)
+{
+	BuildSamplingAxes(SP);
+
+	SP.heightSamples.SetNumZeroed(SP.smoothedHeightMap.Num() + 4);
+	for (int32 cellIdx = 0; cellIdx < SP.smoothedHeightMap.Num(); ++cellIdx)
+	{
+		SP.heightSamples[cellIdx] = SP.smoothedHeightMap[cellIdx];
+	}
+}
+
+//source cells read by the bilerp of any vertex in the component, Max is exclusive
+FIntRect LTerrainGeneration::GetComponentSourceWindow(const LSharedTaskParams& SP, int32 compIdx)
+{
+	return GetTileSourceWindow(SP, compIdx, FIntRect(0, 0, SP.ComponentSizeVerts, SP.ComponentSizeVerts));
+}
+
+//source cells read by the height interpolation of any vertex in the component, Max is exclusive
+//wider than the source window for the cubic policies
+FIntRect LTerrainGeneration::GetComponentHeightWindow(const LSharedTaskParams& SP, int32 compIdx)
+{
+	const LSamplingAxis& axisX = SP.samplingX;
+	const LSamplingAxis& axisY = SP.samplingY;
+	FIntRect verts = GetGlobalVerts(SP, compIdx, FIntRect(0, 0, SP.ComponentSizeVerts, SP.ComponentSizeVerts));
+
+	FIntRect window;
+	window.Min.X = axisX.heightTaps[verts.Min.X];
+	window.Min.Y = axisY.heightTaps[verts.Min.Y];
+	window.Max.X = axisX.heightTaps[(axisX.heightTapCount - 1) * axisX.vertCount + verts.Max.X - 1] + 1;
+	window.Max.Y = axisY.heightTaps[(axisY.heightTapCount - 1) * axisY.vertCount + verts.Max.Y - 1] + 1;
+	return window;
+}
+
+//component local vertices of a tile, row major within the component, Max is exclusive
+FIntRect LTerrainGeneration::GetTileVerts(const LSharedTaskParams& SP, int32 tileIdx)
+{
+	FIntRect tile;
+	tile.Min.X = (tileIdx % SP.tilesPerAxis) * SP.tileVerts;
+	tile.Min.Y = (tileIdx / SP.tilesPerAxis) * SP.tileVerts;
+	tile.Max.X = FMath::Min(tile.Min.X + SP.tileVerts, SP.ComponentSizeVerts);
+	tile.Max.Y = FMath::Min(tile.Min.Y + SP.tileVerts, SP.ComponentSizeVerts);
+	return tile;
+}
+
+//the part of a tile that is not on a border shared with a neighboring component, those vertices come from the seams
+FIntRect LTerrainGeneration::GetTileInterior(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile)
+{
+	const int32 compX = compIdx % SP.landscapeComponentCountSqrt;
+	const int32 compY = compIdx / SP.landscapeComponentCountSqrt;
+	const int32 last = SP.landscapeComponentCountSqrt - 1;
+
+	FIntRect interior = tile;
+	interior.Clip(FIntRect(
+		(compX > 0) ? 1 : 0,
+		(compY > 0) ? 1 : 0,
+		SP.ComponentSizeVerts - ((compX < last) ? 1 : 0),
+		SP.ComponentSizeVerts - ((compY < last) ? 1 : 0)));
+	return interior;
+}
+
+//component local vertices to global landscape vertices
+FIntRect LTerrainGeneration::GetGlobalVerts(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile)
+{
+	const int32 firstVertX = (compIdx % SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1);
+	const int32 firstVertY = (compIdx / SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1);
+	return FIntRect(firstVertX + tile.Min.X, firstVertY + tile.Min.Y, firstVertX + tile.Max.X, firstVertY + tile.Max.Y);
+}
+
+//source cells read by the vertices of a tile of a component, Max is exclusive
+FIntRect LTerrainGeneration::GetTileSourceWindow(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile)
+{
+	int32 firstVertX = (compIdx % SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1);
+	int32 firstVertY = (compIdx / SP.landscapeComponentCountSqrt) * (SP.ComponentSizeVerts - 1);
+
+	//cells only grow along an axis, so the first and last vertex bound the window
+	FIntRect window;
+	window.Min.X = SP.samplingX.cell0[firstVertX + tile.Min.X];
+	window.Min.Y = SP.samplingY.cell0[firstVertY + tile.Min.Y];
+	window.Max.X = SP.samplingX.cell1[firstVertX + tile.Max.X - 1] + 1;
+	window.Max.Y = SP.samplingY.cell1[firstVertY + tile.Max.Y - 1] + 1;
+	return window;
+}
 
-	//update loading bar while waiting for async tasks to finish
-	for (int barCount = taskRunningCount.GetValue(); taskRunningCount.GetValue() > 0 && barCount > 0; )
+//the patch every cell of the window uses, or INDEX_NONE if the window is mixed
+int32 LTerrainGeneration::GetUniformPatchIdx(const LSharedTaskParams& SP, const FIntRect& window)
+{
+	int32 patchIdx = SP.sourcePatchIdxs[window.Min.Y * SP.sourceSizeX + window.Min.X];
+	for (int32 y = window.Min.Y; y < window.Max.Y; ++y)
 	{
-		while (barCount > taskRunningCount.GetValue())
+		const int32* row = SP.sourcePatchIdxs.GetData() + y * SP.sourceSizeX;
+		for (int32 x = window.Min.X; x < window.Max.X; ++x)
 		{
-			loadingBarMain.EnterProgressFrame();
-			--barCount;
+			if (row[x] != patchIdx) return INDEX_NONE;
 		}
 	}
-	///END MAIN LOOP
+	return patchIdx;
+}
+
+static uint32 HashNoise(LNoise* noise)
+{
+	if (noise == nullptr) return 0;
+
+	uint32 hash = GetTypeHash((uint8)noise->GetNoiseType());
+	hash = HashCombine(hash, GetTypeHash(noise->GetSeed()));
+	hash = HashCombine(hash, GetTypeHash(noise->frequency));
+	hash = HashCombine(hash, GetTypeHash(noise->amplitude));
+	return hash;
+}
 
-	///ASSIGN DATA FROM MAIN LOOP (can only be done in main thread)
-	for (int compIdx = 0; compIdx < SP.landscapeComponentCount; ++compIdx)
+uint32 LTerrainGeneration::HashPatch(const LCompiledPatch& patch)
+{
+	//heights and smoothing reach the components through smoothedHeightMap, which is hashed directly
+	uint32 hash = GetTypeHash(patch.noiseMaps.Num());
+	for (LNoise* noise : patch.noiseMaps)
 	{
-		//APPLY DATA
-		ULandscapeComponent* landscapeComponent = terrain->LandscapeComponents[compIdx];
-		landscapeComponent->InitHeightmapData(SP.heightMaps[compIdx], false);
+		hash = HashCombine(hash, HashNoise(noise));
+	}
+
+	hash = HashCombine(hash, GetTypeHash(patch.paintWeights.Num()));
+	for (const LCompiledPaintWeight& paint : patch.paintWeights)
+	{
+		hash = HashCombine(hash, GetTypeHash(paint.layerIdx));
+		hash = HashCombine(hash, GetTypeHash(paint.weight));
+		hash = HashCombine(hash, GetTypeHash(paint.bUseAboveThreshold));
+		hash = HashCombine(hash, GetTypeHash(paint.thresholdLow));
+		hash = HashCombine(hash, GetTypeHash(paint.invFeather));
+		hash = HashCombine(hash, HashNoise(paint.noiseMap));
+	}
 
-		if (SP.layerCount != 0)
-			landscapeComponent->InitWeightmapData(SP.layerInfos, SP.weightMaps[compIdx]);
+	//foliage is only placed in dirty components, so an edit to the scatters alone has to dirty the patch's components
+	//hashed on the game thread like the rest, straight from the patch
+	const TArray<LObjectScatterPtr>& objectScatters = patch.patch->objectScatters;
+	hash = HashCombine(hash, GetTypeHash(objectScatters.Num()));
+	for (const LObjectScatterPtr& scatter : objectScatters)
+	{
+		hash = HashCombine(hash, GetTypeHash(scatter->meshAsset.IsValid() ? scatter->meshAsset->foliageType.ObjectPath : NAME_None));
+		hash = HashCombine(hash, GetTypeHash(scatter->minRadius));
+		hash = HashCombine(hash, GetTypeHash(scatter->maxRadius));
+	}
+	return hash;
+}
 
+//hashes everything a component's output depends on and marks components whose hash differs from the cache as dirty
+void LTerrainGeneration::HashComponents(LSharedTaskParams& SP, const LGenerationCache& cache, bool bIncremental)
+{
+	SP.patchHashes.SetNumUninitialized(SP.compiledPatches.Num());
+	for (int32 i = 0; i < SP.compiledPatches.Num(); ++i)
+	{
+		SP.patchHashes[i] = HashPatch(SP.compiledPatches[i]);
+	}
 
+	//landscape grid and layer setup shared by every component
+	uint32 globalHash = GetTypeHash(SP.ComponentSizeVerts);
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.landscapeComponentCountSqrt));
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.sourceSizeX));
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.sourceSizeY));
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.seed));
+	globalHash = HashCombine(globalHash, GetTypeHash((uint8)SP.lSystem->genSettings.heightInterpolation));
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.terrain->GetActorScale().X));
+	globalHash = HashCombine(globalHash, GetTypeHash(SP.layerCount));
+	for (ULandscapeLayerInfoObject* layerInfo : SP.layerInfos)
+	{
+		globalHash = HashCombine(globalHash, PointerHash(layerInfo));
 	}
-	///END ASSIGNING DATA
 
-	///ASSIGN LANDSCAPE MATERIAL PARAMETERS
-	UMaterialInstanceConstant* landscapeMat = Cast<UMaterialInstanceConstant>(terrain->LandscapeMaterial);
-	if (landscapeMat != nullptr)
+	SP.componentHashes.SetNumUninitialized(SP.landscapeComponentCount);
+	SP.dirtyComponents = TBitArray<>(false, SP.landscapeComponentCount);
+	SP.dirtyComponentCount = 0;
+
+	bool bCacheUsable = bIncremental && cache.componentHashes.Num() == SP.landscapeComponentCount;
+
+	for (int32 compIdx = 0; compIdx < SP.landscapeComponentCount; ++compIdx)
 	{
-		for (int i = 0; i < lSystem.groundTextures.Num(); ++i)
+		uint32 hash = HashCombine(globalHash, GetTypeHash(compIdx));
+
+		//source window including the bilerp halo; smoothed heights already carry the smoothing neighborhood
+		FIntRect window = GetComponentSourceWindow(SP, compIdx);
+		for (int32 y = window.Min.Y; y < window.Max.Y; ++y)
 		{
-			if (lSystem.groundTextures[i]->texture.IsValid())
+			for (int32 x = window.Min.X; x < window.Max.X; ++x)
 			{
-				UTexture2D* diffuse = Cast<UTexture2D>(lSystem.groundTextures[i]->texture.GetAsset());
-				if (diffuse != nullptr)
-				{
-					FName diffuseParamName = FName(*FString::Printf(TEXT("Diffuse_%d"), i));
-					landscapeMat->SetTextureParameterValueEditorOnly(diffuseParamName, diffuse);
-				}
+				hash = HashCombine(hash, SP.patchHashes[SP.sourcePatchIdxs[y * SP.sourceSizeX + x]]);
 			}
+		}
 
-			if (lSystem.groundTextures[i]->normalMap.IsValid())
+		//heights are read over the interpolation's own, possibly wider, window
+		FIntRect heightWindow = GetComponentHeightWindow(SP, compIdx);
+		for (int32 y = heightWindow.Min.Y; y < heightWindow.Max.Y; ++y)
+		{
+			for (int32 x = heightWindow.Min.X; x < heightWindow.Max.X; ++x)
 			{
-				UTexture2D* normalMap = Cast<UTexture2D>(lSystem.groundTextures[i]->normalMap.GetAsset());
-				if (normalMap != nullptr)
-				{
-					FName normMapParamName = FName(*FString::Printf(TEXT("Normal_%d"), i));
-					landscapeMat->SetTextureParameterValueEditorOnly(normMapParamName, normalMap);
-				}
+				hash = HashCombine(hash, GetTypeHash(SP.smoothedHeightMap[y * SP.sourceSizeX + x]));
 			}
 		}
 
-		
+		SP.componentHashes[compIdx] = hash;
+
+		FIntPoint compCoords = FIntPoint(compIdx % SP.landscapeComponentCountSqrt, compIdx / SP.landscapeComponentCountSqrt);
+		if (!SP.region.Contains(compCoords)) continue;
+
+		if (!bCacheUsable || cache.componentHashes[compIdx] != hash)
+		{
+			SP.dirtyComponents[compIdx] = true;
+			++SP.dirtyComponentCount;
+		}
 	}
-	///ASSIGN LANDSCAPE MATERIAL PARAMETERS END
+}
 
-	///PLACE FOLIAGE AND SCATTER OBJECTS START
-	int foliageTaskCount = 0;
-	for (LPatchPtr patch : SP.allUsedPatches)
+//components overlapped by a world space box, for region generation from a selection or volume
+FIntRect LTerrainGeneration::GetComponentRegionFromWorldBox(ALandscape* terrain, const FBox& worldBox)
+{
+	if (terrain->LandscapeComponents.Num() == 0) return FIntRect();
+
+	int32 countSqrt = FMath::Sqrt(terrain->LandscapeComponents.Num());
+	int32 componentSizeQuads = terrain->LandscapeComponents[0]->NumSubsections * terrain->LandscapeComponents[0]->SubsectionSizeQuads;
+	FVector componentSizecm = terrain->GetActorScale() * componentSizeQuads;
+	FVector localMin = worldBox.Min - terrain->GetActorLocation();
+	FVector localMax = worldBox.Max - terrain->GetActorLocation();
+
+	FIntRect region;
+	region.Min.X = FMath::Clamp(FMath::FloorToInt(localMin.X / componentSizecm.X), 0, countSqrt);
+	region.Min.Y = FMath::Clamp(FMath::FloorToInt(localMin.Y / componentSizecm.Y), 0, countSqrt);
+	region.Max.X = FMath::Clamp(FMath::CeilToInt(localMax.X / componentSizecm.X), 0, countSqrt);
+	region.Max.Y = FMath::Clamp(FMath::CeilToInt(localMax.Y / componentSizecm.Y), 0, countSqrt);
+	return region;
+}
+
+//distance in vertices from a global vertex to the nearest region edge that borders untouched components
+//MAX_int32 when the region has no such edge, e.g. when it covers the whole landscape
+int32 LTerrainGeneration::GetRegionBorderDistance(const LSharedTaskParams& SP, int32 gx, int32 gy)
+{
+	//edges on the landscape border have nothing to blend into
+	const int32 quads = SP.ComponentSizeVerts - 1;
+	int32 dist = MAX_int32;
+	if (SP.region.Min.X > 0) dist = FMath::Min(dist, gx - SP.region.Min.X * quads);
+	if (SP.region.Min.Y > 0) dist = FMath::Min(dist, gy - SP.region.Min.Y * quads);
+	if (SP.region.Max.X < SP.landscapeComponentCountSqrt) dist = FMath::Min(dist, SP.region.Max.X * quads - gx);
+	if (SP.region.Max.Y < SP.landscapeComponentCountSqrt) dist = FMath::Min(dist, SP.region.Max.Y * quads - gy);
+	return dist;
+}
+
+//reads the current landscape heights of dirty components near the region edge, before any component is applied
+//applied neighbors would otherwise hand already regenerated heights to the blend along shared seams
+void LTerrainGeneration::CaptureRegionBorderHeights(LSharedTaskParams& SP)
+{
+	const int32 quads = SP.ComponentSizeVerts - 1;
+	const int32 feather = SP.regionBorderFeather;
+	SP.regionBorderHeights.Init(TArray<uint16>(), SP.landscapeComponentCount);
+	if (feather <= 0) return;
+
+	FLandscapeEditDataInterface landscapeEdit(SP.terrain->GetLandscapeInfo());
+	for (TConstSetBitIterator<> it(SP.dirtyComponents); it; ++it)
 	{
-		for (LObjectScatterPtr objectScatter : patch->objectScatters)
+		int32 compIdx = it.GetIndex();
+		const int32 firstVertX = (compIdx % SP.landscapeComponentCountSqrt) * quads;
+		const int32 firstVertY = (compIdx / SP.landscapeComponentCountSqrt) * quads;
+
+		//skip components that are entirely further than feather from every blended edge
+		if (GetRegionBorderDistance(SP, firstVertX, firstVertY) >= feather && GetRegionBorderDistance(SP, firstVertX + quads, firstVertY + quads) >= feather &&
+			GetRegionBorderDistance(SP, firstVertX + quads, firstVertY) >= feather && GetRegionBorderDistance(SP, firstVertX, firstVertY + quads) >= feather)
+			continue;
+
+		int32 minX, minY, maxX, maxY;
+		SP.terrain->LandscapeComponents[compIdx]->GetComponentExtent(minX, minY, maxX, maxY);
+
+		TArray<uint16>& existingHeights = SP.regionBorderHeights[compIdx];
+		existingHeights.SetNumZeroed(SP.ComponentSizeVerts * SP.ComponentSizeVerts);
+		landscapeEdit.GetHeightDataFast(minX, minY, maxX, maxY, existingHeights.GetData(), 0);
+	}
+}
+
+//fades new heights into the captured landscape heights near region edges that border untouched components
+//vertices on the edge itself keep the existing height, so seams with the neighbors stay closed
+bool LTerrainGeneration::BlendRegionBorder(const LSharedTaskParams& SP, int32 compIdx, TArray<uint16>& heightData)
+{
+	const TArray<uint16>& existingHeights = SP.regionBorderHeights[compIdx];
+	if (existingHeights.Num() == 0) return false;
+
+	const int32 quads = SP.ComponentSizeVerts - 1;
+	const int32 feather = SP.regionBorderFeather;
+	const int32 firstVertX = (compIdx % SP.landscapeComponentCountSqrt) * quads;
+	const int32 firstVertY = (compIdx / SP.landscapeComponentCountSqrt) * quads;
+
+	for (int32 i = 0; i < SP.ComponentSizeVerts; ++i)
+	{
+		for (int32 j = 0; j < SP.ComponentSizeVerts; ++j)
 		{
-			++foliageTaskCount;
+			int32 dist = GetRegionBorderDistance(SP, firstVertX + j, firstVertY + i);
+			if (dist >= feather) continue;
+
+			uint16& vertex = heightData[i*SP.ComponentSizeVerts + j];
+			float alpha = BilerpEase((float)dist / feather);
+			vertex = (uint16)FMath::Clamp(FMath::RoundToInt(FMath::Lerp((float)existingHeights[i*SP.ComponentSizeVerts + j], (float)vertex, alpha)), 0, (int32)UINT16_MAX);
 		}
 	}
 
-	FScopedSlowTask loadingBarFoliage(foliageTaskCount + 1, LOCTEXT("InitializeText", "Placing Foliage"));
-	loadingBarFoliage.MakeDialog();
-	loadingBarFoliage.EnterProgressFrame();
+	return true;
+}
+
+//InitHeightmapData takes heights as RGBA 32 bit, RG is the 16 bit height
+void LTerrainGeneration::PackHeightmapData(const TArray<uint16>& heightData, TArray<FColor>& outColors)
+{
+	outColors.SetNumUninitialized(heightData.Num(), false);
+	for (int32 i = 0; i < heightData.Num(); ++i)
+	{
+		outColors[i] = FColor(heightData[i] >> 8, heightData[i] & 0xFF, 0);
+	}
+}
+
+void LGenerationContext::SetComponentWindow(int32 componentCount, int32 layerCount)
+{
+	componentHeights.SetMaxFree(componentCount);
+	componentBlends.SetMaxFree(componentCount);
+	layerWeights.SetMaxFree(componentCount * layerCount);
+	sourceHeights.SetMaxFree(1);
+}
+
+LWeightRowScratch* LGenerationContext::AcquireScratch(int32 rowLength, int32 layerCount)
+{
+	TUniquePtr<LWeightRowScratch> scratch;
+	{
+		FScopeLock scopeLock(&scratchLock);
+		if (freeScratch.Num() > 0) scratch = freeScratch.Pop(false);
+	}
+	if (!scratch.IsValid()) scratch = MakeUnique<LWeightRowScratch>();
+
+	scratch->Init(rowLength, layerCount);
+	return scratch.Release();
+}
 
-	FOnFoliageCompletion onFolaigeCompletion = FOnFoliageCompletion();
-	taskRunningCount.Set(0);
-	onFolaigeCompletion.BindLambda([&taskRunningCount](bool bWasSuccessful) {
-		taskRunningCount.Decrement();
-	});
+void LGenerationContext::ReleaseScratch(LWeightRowScratch* scratch)
+{
+	FScopeLock scopeLock(&scratchLock);
+	freeScratch.Add(TUniquePtr<LWeightRowScratch>(scratch));
+}
 
-	//goes positive X for each +1, then positive Y for a row
-	AInstancedFoliageActor* foliageActor = AInstancedFoliageActor::GetInstancedFoliageActorForCurrentLevel(SP.terrain->GetWorld(), true);
-	TArray<LFoliageParams> FPs = TArray<LFoliageParams>();
-	for (LPatchPtr patch : SP.allUsedPatches)
+SIZE_T LGenerationContext::GetPooledBytes()
+{
+	return componentHeights.GetAllocatedSize() + componentBlends.GetAllocatedSize() + layerWeights.GetAllocatedSize() +
+		sourceHeights.GetAllocatedSize() + foliageGrids.GetAllocatedSize();
+}
+
+//heights, blends and weights of one admitted component
+SIZE_T LTerrainGeneration::GetComponentBufferBytes(const LSharedTaskParams& SP)
+{
+	return (SIZE_T)FMath::Square(SP.ComponentSizeVerts) * (sizeof(uint16) + sizeof(LPatchBlend) + SP.layerCount);
+}
+
+//compact copy of an applied component for foliage placement, the full buffers can be released right after
+void LTerrainGeneration::RetainComponent(const LSharedTaskParams& SP, int32 compIdx, const TBitArray<>& foliagePatches, LRetainedComponent& outRetained)
+{
+	const int32 size = SP.ComponentSizeVerts;
+	const int32 step = LRetainedComponent::HeightStep;
+	const TArray<uint16>& heights = SP.heightMaps[compIdx];
+	const TArray<LPatchBlend>& blends = SP.patchBlendData[compIdx];
+
+	outRetained.sizeVerts = size;
+	outRetained.heightSize = FMath::DivideAndRoundUp(size - 1, step) + 1;
+	outRetained.heights.SetNumUninitialized(FMath::Square(outRetained.heightSize));
+	for (int32 y = 0; y < outRetained.heightSize; ++y)
 	{
-		for (LObjectScatterPtr objectScatter : patch->objectScatters)
+		const uint16* row = heights.GetData() + FMath::Min(y * step, size - 1) * size;
+		for (int32 x = 0; x < outRetained.heightSize; ++x)
 		{
-			int idx = FPs.Add(LFoliageParams());
-			FPs[idx].foliageType = Cast<UFoliageType>(objectScatter->meshAsset->foliageType.GetAsset());
-			FPs[idx].meshInfo = foliageActor->FindOrAddMesh(FPs[idx].foliageType);
-			FPs[idx].patch = patch;
-			FPs[idx].objectScatter = objectScatter;
-			FPs[idx].RNGSeed = taskRunningCount.GetValue();
-
-			taskRunningCount.Increment();
-			(new FAutoDeleteAsyncTask<FLFoliageTask>(FPs[idx], SP, onFolaigeCompletion))->StartBackgroundTask();
+			outRetained.heights[y * outRetained.heightSize + x] = row[FMath::Min(x * step, size - 1)];
 		}
 	}
 
-	//update loading bar while waiting for async tasks to finish
-	for (int barCount = taskRunningCount.GetValue(); taskRunningCount.GetValue() > 0 && barCount > 0; )
+	//foliage patches that reach the component at all
+	outRetained.patchIdxs.Reset();
+	for (const LPatchBlend& blend : blends)
 	{
-		while (barCount > taskRunningCount.GetValue())
+		for (int32 k = 0; k < blend.count; ++k)
 		{
-			loadingBarFoliage.EnterProgressFrame();
-			--barCount;
+			if (blend.weights[k] > 0 && foliagePatches[blend.patchIdxs[k]])
+				outRetained.patchIdxs.AddUnique(blend.patchIdxs[k]);
 		}
 	}
 
-	//spawn foliage instances from accepted locations
-	for (const LFoliageParams& fp : FPs)
+	outRetained.uniformWeights.SetNumUninitialized(outRetained.patchIdxs.Num());
+	outRetained.weights.SetNum(outRetained.patchIdxs.Num());
+	for (int32 slot = 0; slot < outRetained.patchIdxs.Num(); ++slot)
 	{
-		for (const FVector& location : fp.acceptedLocations3D)
+		const int32 patchIdx = outRetained.patchIdxs[slot];
+		TArray<uint8>& slotWeights = outRetained.weights[slot];
+		slotWeights.SetNumUninitialized(blends.Num());
+		bool bUniform = true;
+		for (int32 v = 0; v < blends.Num(); ++v)
 		{
-			FFoliageInstance instance = FFoliageInstance();
-			instance.Location = SP.terrain->GetActorLocation() + location;
-			fp.meshInfo->AddInstance(foliageActor, fp.foliageType, instance);
+			uint8 weight = 0;
+			for (int32 k = 0; k < blends[v].count; ++k)
+			{
+				if (blends[v].patchIdxs[k] == patchIdx) weight = blends[v].weights[k];
+			}
+			slotWeights[v] = weight;
+			bUniform = bUniform && weight == slotWeights[0];
 		}
+
+		outRetained.uniformWeights[slot] = slotWeights[0];
+		if (bUniform) slotWeights.Empty();
+	}
+}
+
+float LRetainedComponent::GetHeight(float x, float y) const
+{
+	//retained vertices are HeightStep apart, except the last pair which ends on the component edge
+	auto Locate = [this](float coord, int32& outIdx, float& outAlpha) {
+		outIdx = FMath::Clamp(FMath::FloorToInt(coord / HeightStep), 0, heightSize - 2);
+		int32 v0 = outIdx * HeightStep;
+		int32 v1 = FMath::Min(v0 + HeightStep, sizeVerts - 1);
+		outAlpha = FMath::Clamp((coord - v0) / (v1 - v0), 0.f, 1.f);
+	};
+
+	int32 x0, y0;
+	float alphaX, alphaY;
+	Locate(x, x0, alphaX);
+	Locate(y, y0, alphaY);
+	const uint16* row0 = heights.GetData() + y0 * heightSize;
+	const uint16* row1 = row0 + heightSize;
+	return FMath::BiLerp((float)row0[x0], (float)row0[x0 + 1], (float)row1[x0], (float)row1[x0 + 1], alphaX, alphaY);
+}
+
+float LRetainedComponent::GetWeight(int32 patchIdx, int32 vertIdx) const
+{
+	for (int32 slot = 0; slot < patchIdxs.Num(); ++slot)
+	{
+		if (patchIdxs[slot] != patchIdx) continue;
+		uint8 weight = (weights[slot].Num() > 0) ? weights[slot][vertIdx] : uniformWeights[slot];
+		return weight * (1.f / 255.f);
 	}
-	///PLACE FOLIAGE AND SCATTER OBJECTS END
+	return 0.f;
+}
+
+SIZE_T LRetainedComponent::GetAllocatedSize() const
+{
+	SIZE_T bytes = heights.GetAllocatedSize() + patchIdxs.GetAllocatedSize() + uniformWeights.GetAllocatedSize() + weights.GetAllocatedSize();
+	for (const TArray<uint8>& slotWeights : weights)
+	{
+		bytes += slotWeights.GetAllocatedSize();
+	}
+	return bytes;
+}
 
-	///UPDATE TERRAIN START
-	for (ULandscapeComponent* landscapeComponent : terrain->LandscapeComponents)
+float LTerrainGeneration::SumNoiseMaps(const TArray<LNoise*>& noiseMaps, float x, float y)
+{
+	float sum = 0.f;
+	for (LNoise* noise : noiseMaps)
 	{
-		landscapeComponent->InvalidateLightingCache();
-		landscapeComponent->UpdateCollisionLayerData();
-		landscapeComponent->UpdateCachedBounds();
-		landscapeComponent->UpdateMaterialInstances();
-		//TODO: figure out other functions to call to update lightmap
+		sum += noise->Noise(x, y);
 	}
-	///UPDATE TERRAIN END
+	return sum;
 }
-#undef LOCTEXT_NAMESPACE
 
 float LTerrainGeneration::SumNoiseMaps(TArray<LNoisePtr>& noiseMaps, float x, float y)
 {
@@ -278,26 +933,207 @@ float LTerrainGeneration::BilerpEase(float t)
 	return t * t * t * (t * (t * 6 - 15) + 10);
 }
 
-//passes idxsTouched to track which textures are used so we can ultimately reduce the amount of paint layers we bilerp
-void LTerrainGeneration::GetWeightMapsAt(LSystem& lsystem, TArray<LPaintWeightPtr>& patchPaints, float x, float y, TArray<float>& outWeights, TArray<int>& idxsTouched)
+//Taps source rows blended down to the row's y a vector of columns at a time, then Taps columns gathered per vertex
+template<int32 Taps>
+static void InterpolateHeightRowTaps(const LSharedTaskParams& SP, LWeightRowScratch& scratch, int32 gx0, int32 count, int32 gy)
 {
-	outWeights.Init(0.f, lsystem.groundTextures.Num());
+	const LSamplingAxis& axisX = SP.samplingX;
+	const LSamplingAxis& axisY = SP.samplingY;
+
+	//vertical pass over every source column the row reads, taps only grow along the axis
+	const int32 firstColumn = axisX.heightTaps[gx0];
+	const int32 columnCount = axisX.heightTaps[(Taps - 1) * axisX.vertCount + gx0 + count - 1] - firstColumn + 1;
+	if (scratch.heightColumns.Num() < Align(columnCount, 4))
+		scratch.heightColumns.SetNumUninitialized(Align(columnCount, 4));
+	float* columns = scratch.heightColumns.GetData();
 
-	for (LPaintWeightPtr paintWeight : patchPaints)
+	const float* rows[Taps];
+	VectorRegister rowWeights[Taps];
+	for (int32 k = 0; k < Taps; ++k)
 	{
-		if (!paintWeight->texture.IsValid()) continue;
+		rows[k] = SP.heightSamples.GetData() + axisY.heightTaps[k * axisY.vertCount + gy] * SP.sourceSizeX + firstColumn;
+		rowWeights[k] = VectorSetFloat1(axisY.heightWeights[k * axisY.vertCount + gy]);
+	}
 
-		int idx = lsystem.groundTextures.Find(paintWeight->texture);
-		idxsTouched.AddUnique(idx);
+	for (int32 c = 0; c < columnCount; c += 4)
+	{
+		VectorRegister sum = VectorMultiply(VectorLoad(rows[0] + c), rowWeights[0]);
+		for (int32 k = 1; k < Taps; ++k)
+		{
+			sum = VectorMultiplyAdd(VectorLoad(rows[k] + c), rowWeights[k], sum);
+		}
+		VectorStore(sum, columns + c);
+	}
 
-		outWeights[idx] = 1.f;
-		/*
-		float noiseVal = paintWeight->noiseMap->Noise(x, y);
-		float halfFeather = paintWeight->thresholdFeather / 2;
-		float alpha = FMath::Clamp((noiseVal - (paintWeight->threshold + halfFeather)) / paintWeight->thresholdFeather, 0.f, 1.f);
-		float weight = FMath::Lerp(0.f, 1.f, alpha);
+	//horizontal pass, cubic overshoot is clamped to the heightmap range
+	const VectorRegister zero = VectorZero();
+	const VectorRegister maxHeight = VectorSetFloat1((float)UINT16_MAX);
+	float* out = scratch.heightRow.GetData();
+	int32 v = 0;
+	for (; v + 4 <= count; v += 4)
+	{
+		VectorRegister sum = zero;
+		for (int32 k = 0; k < Taps; ++k)
+		{
+			const int32* taps = axisX.heightTaps.GetData() + k * axisX.vertCount + gx0 + v;
+			VectorRegister samples = MakeVectorRegister(
+				columns[taps[0] - firstColumn],
+				columns[taps[1] - firstColumn],
+				columns[taps[2] - firstColumn],
+				columns[taps[3] - firstColumn]);
+			sum = VectorMultiplyAdd(VectorLoad(axisX.heightWeights.GetData() + k * axisX.vertCount + gx0 + v), samples, sum);
+		}
+		VectorStore(VectorMin(VectorMax(sum, zero), maxHeight), out + v);
+	}
+	for (; v < count; ++v)
+	{
+		float sum = 0.f;
+		for (int32 k = 0; k < Taps; ++k)
+		{
+			sum += axisX.heightWeights[k * axisX.vertCount + gx0 + v] * columns[axisX.heightTaps[k * axisX.vertCount + gx0 + v] - firstColumn];
+		}
+		out[v] = FMath::Clamp(sum, 0.f, (float)UINT16_MAX);
+	}
+}
 
-		outWeights[idx] = weight;
-		*/
+//source height of a single global vertex from heights laid out like smoothedHeightMap, for previews
+//same taps and weights as InterpolateHeightRow, columns blended first in the same order
+float LTerrainGeneration::InterpolateHeight(const LSharedTaskParams& SP, const TArray<uint16>& heights, int32 gx, int32 gy)
+{
+	const LSamplingAxis& axisX = SP.samplingX;
+	const LSamplingAxis& axisY = SP.samplingY;
+
+	float sum = 0.f;
+	for (int32 kx = 0; kx < axisX.heightTapCount; ++kx)
+	{
+		const int32 column = axisX.heightTaps[kx * axisX.vertCount + gx];
+		float columnSum = 0.f;
+		for (int32 ky = 0; ky < axisY.heightTapCount; ++ky)
+		{
+			columnSum += axisY.heightWeights[ky * axisY.vertCount + gy] * heights[axisY.heightTaps[ky * axisY.vertCount + gy] * SP.sourceSizeX + column];
+		}
+		sum += axisX.heightWeights[kx * axisX.vertCount + gx] * columnSum;
+	}
+	return FMath::Clamp(sum, 0.f, (float)UINT16_MAX);
+}
+
+//source heights of count vertices of global row gy starting at gx0, into scratch.heightRow
+void LTerrainGeneration::InterpolateHeightRow(const LSharedTaskParams& SP, LWeightRowScratch& scratch, int32 gx0, int32 count, int32 gy)
+{
+	if (SP.samplingX.heightTapCount == 2)
+		InterpolateHeightRowTaps<2>(SP, scratch, gx0, count, gy);
+	else
+		InterpolateHeightRowTaps<4>(SP, scratch, gx0, count, gy);
+}
+
+//builds one row of weightmap data from the patch blends stored in scratch, writing [rowOffset, rowOffset + rowLength) of each layer
+//noise is sampled only where a patch has weight, threshold/feather and renormalization run 4 vertices at a time
+void LTerrainGeneration::GetWeightMapRow(const LSharedTaskParams& SP, LWeightRowScratch& scratch, float scaledX0, float scaledXStep, float scaledY, uint8* const* outLayers, int32 rowOffset)
+{
+	const int32 paddedLength = scratch.paddedLength;
+	const VectorRegister zero = VectorZero();
+	const VectorRegister one = VectorOne();
+
+	FMemory::Memzero(scratch.layerWeights.GetData(), scratch.layerWeights.Num() * sizeof(float));
+
+	//unique patches touched anywhere along the row
+	scratch.rowPatchIdxs.Reset();
+	for (int32 v = 0; v < scratch.rowLength; ++v)
+	{
+		for (int32 k = 0; k < scratch.blendCounts[v]; ++k)
+		{
+			scratch.rowPatchIdxs.AddUnique(scratch.blendPatchIdxs[v * LPatchBlend::MaxPatches + k]);
+		}
+	}
+
+	for (int32 patchIdx : scratch.rowPatchIdxs)
+	{
+		const LCompiledPatch& patch = SP.compiledPatches[patchIdx];
+		if (patch.paintWeights.Num() == 0) continue;
+
+		//gather this patch's blend weight along the row, tracking the span where it is non-zero
+		float* patchRowWeights = scratch.patchRowWeights.GetData();
+		FMemory::Memzero(patchRowWeights, paddedLength * sizeof(float));
+		int32 spanStart = scratch.rowLength;
+		int32 spanEnd = 0;
+		for (int32 v = 0; v < scratch.rowLength; ++v)
+		{
+			for (int32 k = 0; k < scratch.blendCounts[v]; ++k)
+			{
+				if (scratch.blendPatchIdxs[v * LPatchBlend::MaxPatches + k] == patchIdx)
+				{
+					patchRowWeights[v] = scratch.blendWeights[v * LPatchBlend::MaxPatches + k];
+					spanStart = FMath::Min(spanStart, v);
+					spanEnd = v + 1;
+					break;
+				}
+			}
+		}
+		//widen to whole vectors, padding is zero weighted
+		spanStart = spanStart & ~3;
+		spanEnd = Align(spanEnd, 4);
+
+		for (const LCompiledPaintWeight& paint : patch.paintWeights)
+		{
+			float* layerRow = scratch.layerWeights.GetData() + paint.layerIdx * paddedLength;
+			const VectorRegister paintWeight = VectorSetFloat1(paint.weight);
+
+			if (paint.noiseMap == nullptr)
+			{
+				for (int32 v = spanStart; v < spanEnd; v += 4)
+				{
+					VectorRegister layerVal = VectorMultiplyAdd(VectorLoad(patchRowWeights + v), paintWeight, VectorLoad(layerRow + v));
+					VectorStore(layerVal, layerRow + v);
+				}
+				continue;
+			}
+
+			float* noiseValues = scratch.noiseValues.GetData();
+			for (int32 v = spanStart; v < spanEnd; ++v)
+			{
+				noiseValues[v] = (patchRowWeights[v] > 0.f) ? paint.noiseMap->Noise(scaledX0 + v * scaledXStep, scaledY) : 0.f;
+			}
+
+			const VectorRegister thresholdLow = VectorSetFloat1(paint.thresholdLow);
+			const VectorRegister invFeather = VectorSetFloat1(paint.invFeather);
+			const bool bAbove = paint.bUseAboveThreshold;
+			for (int32 v = spanStart; v < spanEnd; v += 4)
+			{
+				VectorRegister alpha = VectorMultiply(VectorSubtract(VectorLoad(noiseValues + v), thresholdLow), invFeather);
+				alpha = VectorMin(VectorMax(alpha, zero), one);
+				if (!bAbove) alpha = VectorSubtract(one, alpha);
+
+				VectorRegister weight = VectorMultiply(VectorMultiply(alpha, paintWeight), VectorLoad(patchRowWeights + v));
+				VectorStore(VectorAdd(VectorLoad(layerRow + v), weight), layerRow + v);
+			}
+		}
+	}
+
+	//renormalize so layers sum to 1 wherever anything was painted
+	const VectorRegister epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	for (int32 v = 0; v < paddedLength; v += 4)
+	{
+		VectorRegister sum = zero;
+		for (int32 layerIdx = 0; layerIdx < scratch.layerCount; ++layerIdx)
+		{
+			sum = VectorAdd(sum, VectorLoad(scratch.layerWeights.GetData() + layerIdx * paddedLength + v));
+		}
+		//an unpainted vertex has all zero weights, so the clamped reciprocal leaves it at zero
+		VectorRegister invSum = VectorReciprocal(VectorMax(sum, epsilon));
+		for (int32 layerIdx = 0; layerIdx < scratch.layerCount; ++layerIdx)
+		{
+			float* layerRow = scratch.layerWeights.GetData() + layerIdx * paddedLength;
+			VectorStore(VectorMultiply(VectorLoad(layerRow + v), invSum), layerRow + v);
+		}
+	}
+
+	for (int32 layerIdx = 0; layerIdx < scratch.layerCount; ++layerIdx)
+	{
+		const float* layerRow = scratch.layerWeights.GetData() + layerIdx * paddedLength;
+		uint8* outRow = outLayers[layerIdx] + rowOffset;
+		for (int32 v = 0; v < scratch.rowLength; ++v)
+		{
+			outRow[v] = (uint8)FMath::Clamp(FMath::RoundToInt(layerRow[v] * 255.f), 0, 255);
+		}
 	}
 }
@@ -0,0 +1,187 @@
+#include "LTerrainEditor.h"
+#include "LVariantPreviewJob.h"
+
+#include "Landscape.h"
+
+#define LOCTEXT_NAMESPACE "FLTerrainEditorModule"
+
+void FLVariantPreviewTask::DoWork()
+{
+	LVariantPreviewJob::BuildPreview(SP, settings, patchNoiseMaps, bCancelled, outPreview);
+	completedVariants.Increment();
+}
+
+LVariantPreviewJob::LVariantPreviewJob(LSystem& lSystem, ALandscape* terrain, const TArray<int32>& seeds, FOnVariantsPreviewed onPreviewed) :
+	LQueuedJob(ELJobType::VariantPreview, 1),
+	lSystem(lSystem),
+	terrainPtr(terrain),
+	seeds(seeds),
+	onPreviewed(onPreviewed),
+	bRunning(false),
+	startTime(0.0)
+{
+	SP.context = nullptr;
+	SP.bCancelled = false;
+	SP.dirtyComponentCount = 0;
+	SP.bStreaming = false;
+	bCancelled = false;
+}
+
+LVariantPreviewJob::~LVariantPreviewJob()
+{
+	//the tasks reference members of the job
+	check(!bRunning);
+}
+
+//builds the shared tables and every variant's noise on the game thread, so the tasks never read the editor's noise maps
+void LVariantPreviewJob::Start(FQueuedThreadPool* pool, int32 poolThreadCount)
+{
+	ALandscape* terrain = terrainPtr.Get();
+	if (terrain == nullptr || bCancelled || seeds.Num() == 0) return;
+	if (!LTerrainGeneration::PrepareSourceTables(SP, lSystem, terrain)) return;
+
+	startTime = FPlatformTime::Seconds();
+	settings = lSystem.genSettings;
+	LTerrainGeneration::BuildSamplingAxes(SP);
+
+	const int32 previewSize = FMath::Min(PreviewSize, SP.samplingX.vertCount);
+	previews.SetNum(seeds.Num());
+	variantNoiseMaps.SetNum(seeds.Num());
+	variantPatchNoiseMaps.SetNum(seeds.Num());
+	for (int32 i = 0; i < seeds.Num(); ++i)
+	{
+		previews[i].seed = seeds[i];
+		previews[i].size = previewSize;
+
+		variantNoiseMaps[i].Reset(seeds[i]);
+		variantPatchNoiseMaps[i].SetNum(SP.patches.Num());
+		for (LPatchId patchIdx : SP.usedPatchIdxs)
+		{
+			for (const LNoisePtr& noise : SP.patches[patchIdx]->noiseMaps)
+			{
+				variantPatchNoiseMaps[i][patchIdx].Add(variantNoiseMaps[i].Get(noise));
+			}
+		}
+	}
+
+	bRunning = true;
+	completedVariants.Reset();
+	for (int32 i = 0; i < seeds.Num(); ++i)
+	{
+		(new FAutoDeleteAsyncTask<FLVariantPreviewTask>(SP, settings, variantPatchNoiseMaps[i], previews[i], bCancelled, completedVariants))->StartBackgroundTask(pool);
+	}
+}
+
+bool LVariantPreviewJob::Tick()
+{
+	if (!bRunning) return false;
+	if (completedVariants.GetValue() < previews.Num()) return true;
+
+	bRunning = false;
+	if (!bCancelled)
+	{
+		UE_LOG(LogLTerrain, Log, TEXT("Previewed %d variants at %dx%d in %.3f sec"), previews.Num(), previews[0].size, previews[0].size, FPlatformTime::Seconds() - startTime);
+		onPreviewed.ExecuteIfBound(previews);
+	}
+	return false;
+}
+
+void LVariantPreviewJob::CancelAndWait()
+{
+	Cancel();
+	while (bRunning && completedVariants.GetValue() < previews.Num())
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+	bRunning = false;
+}
+
+float LVariantPreviewJob::GetProgress() const
+{
+	if (!bRunning) return 1.f;
+	return (float)completedVariants.GetValue() / FMath::Max(previews.Num(), 1);
+}
+
+FText LVariantPreviewJob::GetStatusText() const
+{
+	if (bRunning)
+		return FText::Format(LOCTEXT("VariantsPreviewing", "Previewing variants... {0}/{1}"), FText::AsNumber(completedVariants.GetValue()), FText::AsNumber(previews.Num()));
+	return (bCancelled) ? LOCTEXT("VariantsCancelled", "Variant preview cancelled") : LOCTEXT("VariantsDone", "Variant preview finished");
+}
+
+//heights at evenly spaced vertices, computed the way the tile kernels compute them
+//heights are interpolated through the run's policy, and height noise is blended by the same eased bilerp weights
+void LVariantPreviewJob::BuildPreview(const LSharedTaskParams& SP, const LGenSettings& settings, const TArray<TArray<LNoise*>>& patchNoiseMaps, const FThreadSafeBool& bCancelled, LVariantPreview& preview)
+{
+	TArray<uint16> roughHeights;
+	LTerrainGeneration::BuildRoughHeightmap(SP, preview.seed, roughHeights);
+	TArray<uint16> smoothedHeights;
+	LTerrainGeneration::SmoothHeightmap(SP, settings, roughHeights, smoothedHeights);
+
+	const LSamplingAxis& sampleX = SP.samplingX;
+	const LSamplingAxis& sampleY = SP.samplingY;
+	const int32 lastVert = sampleX.vertCount - 1;
+	const int32 lastPixel = FMath::Max(preview.size - 1, 1);
+
+	preview.heights.SetNumUninitialized(preview.size * preview.size);
+	preview.minHeight = UINT16_MAX;
+	preview.maxHeight = 0;
+	for (int32 py = 0; py < preview.size; ++py)
+	{
+		if (bCancelled) return;
+
+		const int32 gy = py * lastVert / lastPixel;
+		const int32* patchRow0 = SP.sourcePatchIdxs.GetData() + sampleY.cell0[gy] * SP.sourceSizeX;
+		const int32* patchRow1 = SP.sourcePatchIdxs.GetData() + sampleY.cell1[gy] * SP.sourceSizeX;
+		const float bilerpY = sampleY.ease[gy];
+
+		for (int32 px = 0; px < preview.size; ++px)
+		{
+			const int32 gx = px * lastVert / lastPixel;
+			const float bilerpX = sampleX.ease[gx];
+
+			//four neighboring patches, merged so a patch's noise is only summed once
+			const int32 cornerPatchIdxs[4] = {
+				patchRow0[sampleX.cell0[gx]],
+				patchRow0[sampleX.cell1[gx]],
+				patchRow1[sampleX.cell0[gx]],
+				patchRow1[sampleX.cell1[gx]] };
+			const float cornerWeights[4] = {
+				(1 - bilerpX)*(1 - bilerpY),
+				(bilerpX)*(1 - bilerpY),
+				(1 - bilerpX)*(bilerpY),
+				(bilerpX)*(bilerpY) };
+
+			int32 patchIdxs[LPatchBlend::MaxPatches];
+			float patchWeights[LPatchBlend::MaxPatches];
+			int32 patchCount = 0;
+			for (int32 corner = 0; corner < 4; ++corner)
+			{
+				int32 k = 0;
+				while (k < patchCount && patchIdxs[k] != cornerPatchIdxs[corner]) ++k;
+				if (k == patchCount)
+				{
+					patchIdxs[k] = cornerPatchIdxs[corner];
+					patchWeights[k] = 0.f;
+					++patchCount;
+				}
+				patchWeights[k] += cornerWeights[corner];
+			}
+
+			float noiseTotal = 0.f;
+			for (int32 k = 0; k < patchCount; ++k)
+			{
+				noiseTotal += patchWeights[k] * LTerrainGeneration::SumNoiseMaps(patchNoiseMaps[patchIdxs[k]], sampleX.noiseCoord[gx], sampleY.noiseCoord[gy]);
+			}
+
+			uint16 height = (int)LTerrainGeneration::InterpolateHeight(SP, smoothedHeights, gx, gy);
+			height += (int)(SP.metersToU16 * noiseTotal);
+
+			preview.heights[py * preview.size + px] = height;
+			preview.minHeight = FMath::Min(preview.minHeight, height);
+			preview.maxHeight = FMath::Max(preview.maxHeight, height);
+		}
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -15,10 +15,16 @@ struct LFoliageParams
 public:
 	UFoliageType* foliageType;
 	FFoliageMeshInfo* meshInfo;
-	LPatchPtr patch;
-	LObjectScatterPtr objectScatter;
-	int RNGSeed;
-	TArray<FVector> acceptedLocations3D;
+	LPatchId patchIdx; //into LSharedTaskParams::patches
+	int32 scatterIdx; //into the patch's objectScatters, only used to key the scatter
+	//copied from the scatter when the job starts, the patch editor can remove it while the task runs
+	float minRadius;
+	float maxRadius;
+	uint32 rngKey; //patch and scatter, keys the scatter's random streams with the project seed so they don't depend on task order
+	TArray<FVector2D> keptPoints; //generated instances left in clean components inside the sample bounds, landscape local cm
+	TArray<TArray<FVector2D>> componentPoints; //poisson samples bucketed by dirty landscape component, filled by the task
+	bool bSampled; //game thread only, set once the task has reported completion
+	int32 trimmedCount; //game thread only, number of applied components already trimmed and placed
 };
 
 class FLFoliageTask : public FNonAbandonableTask
@@ -32,6 +38,12 @@ public:
 		onCompletion(onCompletion)
 	{}
 
+public:
+	//bounding box of the dirty components plus a halo of one radius, in landscape local cm
+	static void GetSampleBounds(const LSharedTaskParams& SP, float minRadiuscm, FVector2D& outMin, FVector2D& outMax);
+	//blend map trim and Z lookup for the samples inside one component, once its data has been generated
+	static void TrimComponent(const LSharedTaskParams& SP, const LFoliageParams& FP, int32 compIdx, TArray<FVector>& outLocations3D);
+
 protected:
 	void DoWork();
 
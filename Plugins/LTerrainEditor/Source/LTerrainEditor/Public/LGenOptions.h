@@ -4,6 +4,7 @@
 
 class SLGroundTexView;
 class SLMeshAssetView;
+struct LVariantPreview;
 
 //Spawns the rule editor tab and ui
 class SLGenOptions : public SCompoundWidget
@@ -22,6 +23,11 @@ public:
 	void ObjectSelectionChanged(LMeshAssetPtr item, ESelectInfo::Type selectType);
 
 	FReply OnGenerateClicked();
+	FReply OnCancelGenerateClicked();
+	FReply OnRegionFromSelectionClicked();
+	FReply OnPreviewVariantsClicked();
+	FReply OnApplyVariantClicked(int32 seed);
+	void ShowVariantPreviews(const TArray<LVariantPreview>& previews);
 
 	FReply OnAddGroundTexClicked();
 	FReply OnRemoveGroundTexClicked();
@@ -36,6 +42,10 @@ public:
 
 	TSharedPtr<SLGroundTexView> groundTexView;
 	TSharedPtr<SLMeshAssetView> meshAssetView;
+
+	TSharedPtr<SHorizontalBox> variantBox;
+	TArray<TSharedPtr<FSlateDynamicImageBrush>> variantBrushes; //release their images when replaced
+	int32 variantImageCount; //keeps dynamic image names unique, the renderer may still hold a released one
 };
 
 class SLGroundTexView : public SCompoundWidget
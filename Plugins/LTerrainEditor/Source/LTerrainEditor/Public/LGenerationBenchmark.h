@@ -0,0 +1,52 @@
+#pragma once
+#include "LTerrainEditor.h"
+#include "LTerrainGeneration.h"
+
+//synthetic landscape for timing the per-vertex component kernel, no ALandscape is needed
+//defaults match a 63 quad, 2x2 subsection component layout (128 verts per component side)
+struct LGenerationBenchmarkParams
+{
+public:
+	LGenerationBenchmarkParams() :
+		subsectionSizeQuads(63),
+		numSubsections(2),
+		componentCountSqrt(4),
+		cellsPerComponent(4),
+		patchCount(4),
+		layerCount(4),
+		noiseMapsPerPatch(2),
+		seed(0)
+	{}
+
+	int subsectionSizeQuads;
+	int numSubsections;
+	int componentCountSqrt;
+	int cellsPerComponent; //source map cells along each side of a component
+	int patchCount;
+	int layerCount;
+	int noiseMapsPerPatch;
+	int32 seed;
+};
+
+//one traversal of every component, single threaded so the numbers reflect a single worker's cache
+struct LGenerationBenchmarkResult
+{
+public:
+	FString traversal;
+	FIntPoint unitSize; //vertices in one work unit
+	double seconds;
+	double vertsPerSecond;
+	SIZE_T unitOutputBytes; //heights, blends and weights written by one work unit
+};
+
+//headless timing of the selected tile kernel over full width row bands and square tiles
+//run with the console command "LTerrain.BenchmarkGeneration [componentCountSqrt] [patches] [layers]"
+//cache misses are not counted here, read them from a profiler while the command runs; unitOutputBytes shows the working set each traversal keeps hot
+class LGenerationBenchmark
+{
+public:
+	static void BuildSyntheticLSystem(LSystem& lSystem, const LGenerationBenchmarkParams& params);
+	static void BuildSharedParams(LSharedTaskParams& SP, LSystem& lSystem, const LGenerationBenchmarkParams& params);
+	static LGenerationBenchmarkResult Run(LSharedTaskParams& SP, const FString& traversal, FIntPoint unitSize);
+	static void RunAndLog(const LGenerationBenchmarkParams& params);
+};
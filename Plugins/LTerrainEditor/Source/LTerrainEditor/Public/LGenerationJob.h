@@ -0,0 +1,83 @@
+#pragma once
+#include "LTerrainEditor.h"
+#include "LTerrainGeneration.h"
+#include "LFoliageTask.h"
+#include "LGenerationQueue.h"
+
+//a full or region generation of one landscape, queued with LTerrainGeneration::GenerateTerrain
+//preparation runs when the queue starts the job, so it sees the LSystem as it is then rather than when it was queued
+//components and foliage are computed on the queue's pool while Tick applies finished work on the game thread in budgeted slices
+class LGenerationJob : public LQueuedJob
+{
+public:
+	LGenerationJob(LSystem& lSystem, ALandscape* terrain, LGenerationCache& cache, const FIntRect* componentRegion);
+	virtual ~LGenerationJob();
+
+	virtual void Start(FQueuedThreadPool* pool, int32 poolThreadCount) override;
+	virtual bool Tick() override;
+
+	//workers stop at their next row, the job finishes once they have all reported back
+	virtual void Cancel() override;
+	//blocks until every worker task has returned, for module shutdown
+	virtual void CancelAndWait() override;
+
+	//a generation covering at least the same components of the same landscape
+	virtual bool Supersedes(const LQueuedJob& older) const override;
+
+	virtual bool IsRunning() const override { return bRunning; }
+	bool WasCancelled() const { return SP.bCancelled; }
+	virtual float GetProgress() const override;
+	virtual FText GetStatusText() const override;
+
+	LSharedTaskParams SP;
+
+private:
+	void AdmitComponents();
+	void LaunchWorkers();
+	bool ApplyReadyComponents(double sliceEnd);
+	bool PlaceFoliage(double sliceEnd);
+	void ReleaseComponent(int32 compIdx);
+	void ReleaseWeightmaps(int32 compIdx);
+	bool AreTasksDone() const;
+	void Finish();
+
+	float GetComponentProgress() const;
+	float GetFoliageProgress() const;
+	static FText FormatEta(double stageStartTime, float stageProgress);
+
+	LSystem& lSystem;
+	LGenerationCache& cache;
+	TWeakObjectPtr<ALandscape> terrainPtr; //the landscape can be deleted while the job waits or runs
+	FIntRect componentRegion; //requested region, only used for RegionGeneration jobs
+	FQueuedThreadPool* pool;
+	bool bRunning;
+	double applySliceSeconds; //game thread time spent applying per tick, keeps the editor responsive
+
+	int32 workerCount; //worker tasks kept running while there are unclaimed tiles
+	int32 componentsInFlight; //admitted but not yet applied
+	int32 componentsHeld; //admitted and still holding their buffers, applied components keep them until foliage has trimmed them
+	int32 maxComponentsInFlight; //cap on componentsHeld
+	TQueue<int32, EQueueMode::Mpsc> readyComponents;
+
+	TArray<int32> appliedComponents; //in order of application, foliage trims walk this list
+	int32 releasedCount; //applied components whose buffers have been freed
+	TBitArray<> blendedComponents;
+	TArray<FColor> packedHeights; //reused for every applied component
+
+	//streaming mode, admission also waits for retained copies to be trimmed once they would exceed the budget
+	SIZE_T streamingBudgetBytes;
+	SIZE_T componentBufferBytes; //per admitted component
+	SIZE_T retainedBytes;
+	SIZE_T peakBufferBytes; //admitted buffers plus retained copies, for the log
+	TBitArray<> foliagePatches; //patches with object scatters, the only ones retained copies keep weights for
+
+	AInstancedFoliageActor* foliageActor;
+	TArray<LFoliageParams> FPs; //tasks hold references into FPs, it must not reallocate
+	TQueue<int32, EQueueMode::Mpsc> sampledFoliage;
+	int32 sampledFoliageCount;
+	int32 trimmedFoliageCount; //(scatter, component) pairs placed
+	TArray<FVector> trimmedLocations;
+
+	double componentStageStart;
+	double foliageStageStart;
+};
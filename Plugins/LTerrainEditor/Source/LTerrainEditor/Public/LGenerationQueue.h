@@ -0,0 +1,85 @@
+#pragma once
+#include "LTerrainEditor.h"
+
+#include "Containers/Ticker.h"
+#include "Misc/QueuedThreadPool.h"
+
+enum class ELJobType : uint8
+{
+	FullGeneration,
+	RegionGeneration,
+	LoDIteration,
+	VariantPreview
+};
+
+//a unit of work run by LGenerationQueue, one at a time on the game thread with its workers on the queue's pool
+class LQueuedJob
+{
+public:
+	LQueuedJob(ELJobType type, int32 priority) :
+		type(type),
+		priority(priority),
+		sequence(0)
+	{}
+	virtual ~LQueuedJob() {}
+
+	virtual void Start(FQueuedThreadPool* pool, int32 poolThreadCount) = 0;
+	//called every editor tick while active, returns false once finished
+	virtual bool Tick() = 0;
+	virtual void Cancel() = 0;
+	virtual void CancelAndWait() = 0;
+	virtual bool IsRunning() const = 0;
+	virtual float GetProgress() const = 0;
+	virtual FText GetStatusText() const = 0;
+
+	//true if this job makes older's result pointless, older is dropped from the queue or cancelled if already running
+	virtual bool Supersedes(const LQueuedJob& older) const { return false; }
+
+	ELJobType type;
+	int32 priority; //higher runs first, equal priorities run in the order they were queued
+	uint64 sequence;
+};
+
+typedef TSharedPtr<LQueuedJob> LQueuedJobPtr;
+
+//generation requests from the editor ui, run by priority on a dedicated thread pool
+//keeps long generations from starving the editor's own GThreadPool work (shader compiles, asset loading, async tasks)
+class LGenerationQueue
+{
+public:
+	LGenerationQueue();
+	~LGenerationQueue();
+
+	void Enqueue(LQueuedJobPtr job);
+	//cancels the running job and drops every queued one
+	void CancelAll();
+	//module shutdown, blocks until the running job's workers have returned
+	void Shutdown();
+
+	bool IsBusy() const { return activeJob.IsValid() || pendingJobs.Num() > 0; }
+	int32 GetPendingCount(ELJobType type) const;
+	//true while a job of this type is running
+	bool IsActive(ELJobType type) const { return activeJob.IsValid() && activeJob->type == type; }
+	int32 GetPendingCount() const { return pendingJobs.Num(); }
+	//running job, or the last one to finish, for progress display
+	LQueuedJobPtr GetStatusJob() const { return (activeJob.IsValid()) ? activeJob : lastJob; }
+
+	//worker count for the pool, 0 picks one from the core count; applied the next time the queue is idle
+	void SetPoolSize(int32 threadCount);
+	int32 GetPoolThreadCount() const { return poolThreadCount; }
+
+private:
+	bool Tick(float deltaTime);
+	void EnsurePool();
+	void DestroyPool();
+
+	FDelegateHandle tickerHandle;
+	FQueuedThreadPool* pool;
+	int32 poolThreadCount; //threads in the current pool, 0 if none created yet
+	int32 requestedThreadCount;
+	uint64 nextSequence;
+
+	LQueuedJobPtr activeJob;
+	LQueuedJobPtr lastJob;
+	TArray<LQueuedJobPtr> pendingJobs; //sorted by priority, then sequence
+};
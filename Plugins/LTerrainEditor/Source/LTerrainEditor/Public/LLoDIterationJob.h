@@ -0,0 +1,72 @@
+#pragma once
+#include "LTerrainEditor.h"
+#include "LGenerationQueue.h"
+
+#include "Async/AsyncWork.h"
+
+DECLARE_DELEGATE_OneParam(FOnLoDIterated, LSymbol2DMapPtr)
+
+class FLLoDIterationTask : public FNonAbandonableTask
+{
+	friend class FAutoDeleteAsyncTask<FLLoDIterationTask>;
+
+public:
+	FLLoDIterationTask(const LSystemHandles& rules, const TArray<LSymbolId>& sourceIds, int32 width, int32 height, TArray<LSymbolId>& outIds, FThreadSafeBool& bDone) :
+		rules(rules),
+		sourceIds(sourceIds),
+		width(width),
+		height(height),
+		outIds(outIds),
+		bDone(bDone)
+	{}
+
+protected:
+	//ids only, symbols are resolved back to pointers on the game thread
+	void DoWork()
+	{
+		rules.IterateIds(sourceIds, width, height, outIds);
+		bDone = true;
+	}
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FLLoDIterationTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+protected:
+	const LSystemHandles& rules;
+	const TArray<LSymbolId>& sourceIds;
+	int32 width;
+	int32 height;
+	TArray<LSymbolId>& outIds;
+	FThreadSafeBool& bDone;
+};
+
+//iterates the highest LoD of the LSystem on the queue's pool and appends the result on the game thread
+//LoDs queued back to back each build on the one before, so none of them supersede each other
+class LLoDIterationJob : public LQueuedJob
+{
+public:
+	LLoDIterationJob(LSystem& lSystem, FOnLoDIterated onIterated);
+	virtual ~LLoDIterationJob();
+
+	virtual void Start(FQueuedThreadPool* pool, int32 poolThreadCount) override;
+	virtual bool Tick() override;
+	virtual void Cancel() override { bCancelled = true; }
+	virtual void CancelAndWait() override;
+	virtual bool IsRunning() const override { return bRunning; }
+	virtual float GetProgress() const override { return (bRunning) ? 0.f : 1.f; }
+	virtual FText GetStatusText() const override;
+
+private:
+	LSystem& lSystem;
+	LSystemHandles rulesSnapshot; //rules as they were when the job started, the editor may change them while the task runs
+	TArray<LSymbolId> sourceIds; //the last LoD when the job started, the map editor may paint it while the task runs
+	int32 sourceWidth;
+	int32 sourceHeight;
+	TArray<LSymbolId> newIds;
+	FOnLoDIterated onIterated;
+	FThreadSafeBool bDone;
+	bool bCancelled;
+	bool bRunning;
+};
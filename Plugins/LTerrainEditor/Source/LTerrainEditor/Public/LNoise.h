@@ -1,6 +1,5 @@
 #pragma once
 #include "LTerrainEditor.h"
-#include <random>
 
 class LNoise;
 class LNoiseObject;
@@ -19,11 +18,12 @@ enum class ENoiseType : uint8
 class LNoise
 {
 public:
-	LNoise(ENoiseType noiseType);
 	LNoise(ENoiseType noiseType, int32 seedVal);
+	LNoise(const LNoise& source, int32 seedVal);
 	void Reseed();
 	void Reseed(int32 seedVal);
 	ENoiseType GetNoiseType();
+	int32 GetSeed();
 	float Noise(float x, float y);
 
 private:
@@ -43,10 +43,10 @@ class LNoiseObject
 public:
 	virtual float Noise(float x, float y) = 0;
 	virtual void Initialize(int32 seedVal) = 0;
+	int32 GetSeed() const { return seed; }
 
 protected:
 	int32 seed;
-	FCriticalSection RNGLock;
 };
 
 class LColoredNoise : public LNoiseObject
@@ -61,11 +61,9 @@ private:
 	// 0 exponent: even weighted frequencies
 	//+1 exponent: favors high frequencies
 	float exponent;
-	std::default_random_engine generatorX;
-	std::default_random_engine generatorY;
-	std::uniform_real_distribution<float> tauShiftDistribution;
-	std::uniform_int_distribution<int> generate2ndSeed;
 	static float TAU;
+	static const int FREQ_COUNT = 30;
+	float normalizedWeights[FREQ_COUNT]; //weight of each frequency divided by the sum of all weights
 	int32 seed2;
 };
 
@@ -79,8 +77,4 @@ public:
 private:
 	float DotGrad(int ix, int iy, float x, float y);
 	float EaseFunction(float t);
-
-private:
-	std::uniform_real_distribution<float> gradVecRotDistribution;
-	std::default_random_engine generator;
 };
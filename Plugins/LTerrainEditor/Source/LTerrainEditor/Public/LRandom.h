@@ -0,0 +1,91 @@
+#pragma once
+#include "LTerrainEditor.h"
+
+//every use of randomness in the pipeline, keeps the numbers of different stages independent under the same seed
+enum class ELRandomStage : uint32
+{
+	NoiseCreation, //seeds of new noise maps in the editor
+	NoiseSeed, //per run noise seeds, from the project seed and the noise map's own seed
+	PerlinGradient,
+	ColoredNoiseShiftX,
+	ColoredNoiseShiftY,
+	ColoredNoiseSeed,
+	RoughHeight,
+	FoliageSampling,
+	FoliageTrim,
+};
+
+//counter based random numbers: a number is a pure function of (seed, stage, keys), there is no state to share
+//so any stage can run in parallel, in any order, or only in part, and still produce exactly the same values
+class LRandom
+{
+public:
+	static FORCEINLINE uint32 Hash(uint32 seed, ELRandomStage stage, uint32 key0, uint32 key1 = 0, uint32 key2 = 0)
+	{
+		uint32 hash = Mix(seed ^ ((uint32)stage * 0x9E3779B9u));
+		hash = Mix(hash ^ (key0 * 0xCC9E2D51u + 0x7F4A7C15u));
+		hash = Mix(hash ^ (key1 * 0xCC9E2D51u + 0x7F4A7C15u));
+		return Mix(hash ^ (key2 * 0xCC9E2D51u + 0x7F4A7C15u));
+	}
+
+	//in [0, 1)
+	static FORCEINLINE float Fraction(uint32 seed, ELRandomStage stage, uint32 key0, uint32 key1 = 0, uint32 key2 = 0)
+	{
+		return (Hash(seed, stage, key0, key1, key2) >> 8) * (1.f / 16777216.f);
+	}
+
+	static FORCEINLINE float FRandRange(float min, float max, uint32 seed, ELRandomStage stage, uint32 key0, uint32 key1 = 0, uint32 key2 = 0)
+	{
+		return min + (max - min) * Fraction(seed, stage, key0, key1, key2);
+	}
+
+private:
+	//murmur3 finalizer
+	static FORCEINLINE uint32 Mix(uint32 hash)
+	{
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6Bu;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35u;
+		hash ^= hash >> 16;
+		return hash;
+	}
+};
+
+//sequential numbers for inherently serial consumers like poisson sampling, the counter is the last key
+//matches the parts of FRandomStream the pipeline uses
+class LRandomStream
+{
+public:
+	LRandomStream(uint32 seed, ELRandomStage stage, uint32 key0, uint32 key1 = 0) :
+		seed(seed),
+		stage(stage),
+		key0(key0),
+		key1(key1),
+		counter(0)
+	{}
+
+	FORCEINLINE float GetFraction()
+	{
+		return LRandom::Fraction(seed, stage, key0, key1, counter++);
+	}
+
+	FORCEINLINE float FRandRange(float min, float max)
+	{
+		return min + (max - min) * GetFraction();
+	}
+
+	//inclusive of max
+	FORCEINLINE int32 RandRange(int32 min, int32 max)
+	{
+		uint64 range = (uint64)((int64)max - min + 1);
+		return min + (int32)(((uint64)LRandom::Hash(seed, stage, key0, key1, counter++) * range) >> 32);
+	}
+
+private:
+	uint32 seed;
+	ELRandomStage stage;
+	uint32 key0;
+	uint32 key1;
+	uint32 counter;
+};
@@ -20,16 +20,70 @@ typedef TSharedPtr<LObjectScatter, ESPMode::ThreadSafe> LObjectScatterPtr;
 typedef TArray<TArray<TSharedPtr<LSymbol, ESPMode::ThreadSafe>>> LSymbol2DMap;
 typedef TSharedPtr<LSymbol2DMap, ESPMode::ThreadSafe> LSymbol2DMapPtr;
 
+//indices into the flat tables of an LSystemHandles, only meaningful for the handles they came from
+typedef int32 LSymbolId;
+typedef int32 LRuleId;
+typedef int32 LPatchId; //also indexes LSystem::patches
+
+//how smoothedHeightMap is upsampled to landscape vertices
+enum class ELHeightInterpolation : uint8
+{
+	Linear,
+	EasedLinear, //bilinear with a quintic ease, flat at every source cell center
+	CatmullRom, //bicubic through the cell heights
+	BSpline, //bicubic approximating the cell heights, smoothest
+};
+
+//terrain generation options, edited in the generation options tab
+class LGenSettings
+{
+public:
+	LGenSettings() :
+		seed(0),
+		bIncremental(true),
+		smoothRadius(1),
+		smoothIterations(1),
+		bSmoothGaussian(false),
+		heightInterpolation(ELHeightInterpolation::EasedLinear),
+		bUseRegion(false),
+		region(0, 0, 1, 1),
+		regionBorderFeather(16),
+		workerThreadCount(0),
+		bStreaming(false),
+		streamingBudgetMB(2048),
+		variantCount(4)
+	{}
+
+	int32 seed;
+	bool bIncremental; //only recompute landscape components whose inputs changed since the last generation
+
+	//the defaults, radius 1 and one iteration, are an even 3x3 box, so results differ slightly from generations made before
+	//these settings existed, whose 3x3 pass counted the center cell twice
+	int smoothRadius; //in source map cells, 1 is a 3x3 box
+	int smoothIterations;
+	bool bSmoothGaussian; //each iteration is 3 box passes, approximating a gaussian of the same radius
+	ELHeightInterpolation heightInterpolation;
+	bool bUseRegion; //only regenerate the components inside region
+	FIntRect region; //in landscape components, Max exclusive
+	int regionBorderFeather; //vertices over which new heights fade into the existing landscape at the region edge
+	int workerThreadCount; //threads in the generation pool, 0 to pick from the core count
+	bool bStreaming; //release each component's buffers as soon as it is applied, foliage reads a compact retained copy instead
+	int streamingBudgetMB; //cap on component buffers and retained copies held at once while streaming
+	int variantCount; //seeds previewed side by side by Preview Variants, seed, seed + 1, ...
+};
+
 class LSystem
 {
 public:
+	LSystem() : createdNoiseCount(0) {}
+
 	void Reset();
 	void GenerateSomeDefaults();
 	LSymbol2DMapPtr IterateLString(LSymbol2DMapPtr source);
-	LRulePtr GetLRuleMatch(LSymbol2DMapPtr map, int xIdx, int yIdx);
 	LPatchPtr GetLPatchMatch(LSymbolPtr toMatch);
 	static LSymbolPtr GetMapSymbolFrom01Coords(LSymbol2DMapPtr map, float xPercCoord, float yPercCoord);
 	LSymbolPtr GetDefaultSymbol();
+	int32 NextNoiseSeed(); //game thread only
 
 public:
 	TArray<LRulePtr> rules;
@@ -38,10 +92,49 @@ public:
 	TArray<LSymbol2DMapPtr> lSystemLoDs;
 	TArray<LGroundTexturePtr> groundTextures;
 	TArray<LMeshAssetPtr> meshAssets;
+	LGenSettings genSettings;
+	uint32 createdNoiseCount; //noise maps created through NextNoiseSeed since the last Reset
 
 	static const int DIMS = 5;
 };
 
+//stable integer ids for the symbols, rules and patches of an LSystem, in contiguous tables
+//rule iteration and generation run on ids, so their loops never copy a shared pointer and touch its refcount
+//built from the LSystem on the game thread, which also makes it a snapshot the editors can change freely afterwards
+class LSystemHandles
+{
+public:
+	static const LSymbolId NullSymbolId = 0; //empty map cells
+	static const LSymbolId MatchAnySymbolId = 1;
+
+	struct LCompiledRule
+	{
+		LSymbolId matchVal;
+		bool bMatchNeighbors;
+		LSymbolId neighbors[9]; //[y * 3 + x]
+		LSymbolId replacement[LSystem::DIMS * LSystem::DIMS]; //[y * DIMS + x]
+	};
+
+	void Build(const LSystem& lSystem);
+	LSymbolId GetSymbolId(const LSymbolPtr& symbol); //symbols not seen yet get a new id
+	//map as ids, [y * width + x]
+	void ToIds(const LSymbol2DMap& map, TArray<LSymbolId>& outIds);
+	LSymbol2DMapPtr ToMap(const TArray<LSymbolId>& ids, int32 width, int32 height) const;
+
+	//the rule used to replace cell (x, y), INDEX_NONE if the cell just propagates
+	LRuleId MatchRule(const LSymbolId* map, int32 width, int32 height, int32 x, int32 y) const;
+	//one iteration on ids only, touches no symbol pointers so it can run off the game thread
+	void IterateIds(const TArray<LSymbolId>& sourceIds, int32 width, int32 height, TArray<LSymbolId>& outIds) const;
+	LSymbol2DMapPtr IterateLString(const LSymbol2DMap& source);
+
+public:
+	TArray<LSymbolPtr> symbols; //[symbol id], keeps every symbol alive for as long as the handles exist
+	TMap<const LSymbol*, LSymbolId> symbolIds;
+	TArray<LCompiledRule> rules; //[rule id], same order as LSystem::rules
+	TArray<TArray<LRuleId, TInlineAllocator<4>>> symbolRules; //[symbol id], rules matching the symbol in order
+	TArray<LPatchId> symbolPatches; //[symbol id], first patch matching the symbol, INDEX_NONE if there is none
+};
+
 class LSymbol
 {
 public:
@@ -146,13 +239,23 @@ public:
 	FAssetData normalMap;
 };
 
+//paints a ground texture over a patch, optionally broken up where noiseMap crosses threshold
 class LPaintWeight
 {
 public:
+	LPaintWeight() :
+		texture(LGroundTexturePtr()),
+		weight(1.f),
+		noiseMap(LNoisePtr()),
+		bUseAboveThreshold(true),
+		threshold(0.f),
+		thresholdFeather(0.5f)
+	{}
+
 	LGroundTexturePtr texture;
-	float weight;
-	LNoisePtr noiseMap;
-	bool bUseAboveThreshold;
-	float threshold;
-	float thresholdFeather;
+	float weight; //relative to other paint weights, weights are renormalized per vertex
+	LNoisePtr noiseMap; //no noise map paints the full weight everywhere
+	bool bUseAboveThreshold; //paint where noise is above threshold, otherwise below
+	float threshold; //in the same world meter units as LNoise::Noise output
+	float thresholdFeather; //width of the linear fade centered on threshold
 };
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "LTerrainEditor.h"
+
+//parameters for one synthetic LSystem used to time the rule engine
+struct LSystemBenchmarkParams
+{
+public:
+	LSystemBenchmarkParams() :
+		symbolCount(6),
+		ruleCount(8),
+		neighborRuleFraction(0.25f),
+		baseSize(3),
+		maxLoD(4),
+		seed(0)
+	{}
+
+	int symbolCount;
+	int ruleCount;
+	float neighborRuleFraction; //0..1, fraction of rules with bMatchNeighbors set
+	int baseSize; //LoD 0 is baseSize x baseSize
+	int maxLoD;
+	int32 seed;
+};
+
+//results for a single IterateLString call (LoD n-1 -> LoD n)
+struct LSystemBenchmarkResult
+{
+public:
+	int lod;
+	int64 cellsOut;
+	double seconds;
+	double cellsPerSecond;
+	double mapBlocksPerCell; //heap blocks the new LoD's arrays hold per cell, derived from its shape rather than measured during the call
+	SIZE_T lodMemoryBytes; //all of lSystemLoDs after this iteration
+};
+
+//headless timing of IterateLString, run with the console command
+//"LTerrain.BenchmarkLSystem [symbols] [rules] [neighborFraction] [maxLoD]"
+//or with no arguments to sweep a set of presets
+class LSystemBenchmark
+{
+public:
+	static void BuildSyntheticLSystem(LSystem& lSystem, const LSystemBenchmarkParams& params);
+	static TArray<LSystemBenchmarkResult> Run(const LSystemBenchmarkParams& params);
+	static void RunAndLog(const LSystemBenchmarkParams& params);
+	static void RunPresets();
+	static int64 CountMapBlocks(const LSymbol2DMap& map);
+	static SIZE_T GetLoDMemory(const TArray<LSymbol2DMapPtr>& lods);
+};
@@ -4,29 +4,43 @@
 
 #include "Async/AsyncWork.h"
 
-DECLARE_DELEGATE_OneParam(FOnCompletion, bool)
+DECLARE_DELEGATE_OneParam(FOnComponentReady, int32)
 
+//one generation worker, several run at once and share the tiles of every admitted component
 class FLTerrainComponentMainTask : public FNonAbandonableTask
 {
 	friend class FAutoDeleteAsyncTask<FLTerrainComponentMainTask>;
 
 public:
-	FLTerrainComponentMainTask(int32 compIdx, LSharedTaskParams& SP, FOnCompletion onCompletion) :
-		compIdx(compIdx),
+	FLTerrainComponentMainTask(LSharedTaskParams& SP, FOnComponentReady onComponentReady) :
 		SP(SP),
-		onCompletion(onCompletion)
+		onComponentReady(onComponentReady)
 	{}
 
+	static LTileKernel SelectTileKernel(const LSharedTaskParams& SP);
+	//verts are global landscape vertices, Max exclusive; weightScratch must be at least as wide as verts
+	//the generic kernel, handles every configuration
+	static void GenerateTile(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, LWeightRowScratch& weightScratch);
+	static void GenerateTileUniform(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, int32 patchIdx, LWeightRowScratch& weightScratch);
+	static LTileTarget GetComponentTarget(LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile);
+
+	//seams are computed once by the workers, before any component tile, and copied into both components sharing them
+	static void PrepareSeams(LSharedTaskParams& SP);
+	static void GenerateSeam(LSharedTaskParams& SP, int32 segmentIdx, LWeightRowScratch& weightScratch);
+	static void CopySeams(LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile);
+
 protected:
 	void DoWork();
 
+	template<bool bPaint, bool bHeightNoise, bool bSingleLayer>
+	static void GenerateTileKernel(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, LWeightRowScratch& weightScratch);
+
 	FORCEINLINE TStatId GetStatId() const
 	{
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FLTerrainComponentMainTask, STATGROUP_ThreadPoolAsyncTasks);
 	}
 
 protected:
-	int32 compIdx;
-	FOnCompletion onCompletion;
+	FOnComponentReady onComponentReady;
 	LSharedTaskParams& SP;
 };
\ No newline at end of file
@@ -13,8 +13,12 @@
 
 #include "LSystem.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogLTerrain, Log, All);
+
 class FToolBarBuilder;
 class FMenuBuilder;
+class LGenerationCache;
+class LGenerationQueue;
 
 class FLTerrainEditorModule : public IModuleInterface
 {
@@ -35,6 +39,8 @@ public:
 	TSharedRef<SDockTab> SpawnGenOptionsTab(const FSpawnTabArgs& SpawnTabArgs);
 	
 	LSystem lSystem;
+	TSharedPtr<LGenerationCache> generationCache;
+	TSharedPtr<LGenerationQueue> generationQueue;
 
 private:
 	void AddToolbarExtension(FToolBarBuilder& Builder);
@@ -2,45 +2,415 @@
 #include "LTerrainEditor.h"
 #include "Landscape.h"
 
+//paint weight with its landscape layer resolved up front
+//settings are copied rather than pointed to, the patch editor can remove the paint weight while a job runs
+struct LCompiledPaintWeight
+{
+public:
+	int32 layerIdx; //index into LSharedTaskParams::layerInfos / lSystem groundTextures
+	float weight;
+	bool bUseAboveThreshold;
+	LNoise* noiseMap; //null paints weight everywhere
+	float thresholdLow; //threshold - thresholdFeather/2
+	float invFeather;
+};
+
+//blend of up to 4 source patches at a single vertex, weights quantized to 8 bits and summing to 255
+//replaces a dense float array per patch, since a vertex only ever bilerps between 4 source cells
+//14 bytes per vertex however many patches there are, 4 uint16 indices and 5 uint8s padded to 2 byte alignment
+struct LPatchBlend
+{
+public:
+	static const int32 MaxPatches = 4;
+
+	uint16 patchIdxs[MaxPatches];
+	uint8 weights[MaxPatches];
+	uint8 count;
+
+	FORCEINLINE float GetWeight(int32 patchIdx) const
+	{
+		for (int32 k = 0; k < count; ++k)
+		{
+			if (patchIdxs[k] == patchIdx) return weights[k] * (1.f / 255.f);
+		}
+		return 0.f;
+	}
+
+	static LPatchBlend Quantize(const int32* inPatchIdxs, const float* inWeights, int32 inCount)
+	{
+		LPatchBlend blend;
+		blend.count = (uint8)FMath::Min(inCount, MaxPatches);
+
+		int32 sum = 0;
+		int32 largest = 0;
+		for (int32 k = 0; k < blend.count; ++k)
+		{
+			blend.patchIdxs[k] = (uint16)inPatchIdxs[k];
+			blend.weights[k] = (uint8)FMath::Clamp(FMath::RoundToInt(inWeights[k] * 255.f), 0, 255);
+			sum += blend.weights[k];
+			if (inWeights[k] > inWeights[largest]) largest = k;
+		}
+
+		//push rounding error onto the dominant patch so weights still sum to 1
+		if (blend.count > 0)
+			blend.weights[largest] = (uint8)FMath::Clamp(blend.weights[largest] + 255 - sum, 0, 255);
+
+		return blend;
+	}
+};
+static_assert(sizeof(LPatchBlend) == 14, "LPatchBlend size changed, update its comment");
+
+//per task scratch for building one tile row of weightmap and height data
+//rows are padded to a multiple of 4 so the SIMD passes need no scalar tail
+struct LWeightRowScratch
+{
+public:
+	void Init(int32 inRowLength, int32 inLayerCount)
+	{
+		rowLength = inRowLength;
+		paddedLength = Align(inRowLength, 4);
+		layerCount = inLayerCount;
+		blendPatchIdxs.SetNumZeroed(paddedLength * LPatchBlend::MaxPatches);
+		blendWeights.SetNumZeroed(paddedLength * LPatchBlend::MaxPatches);
+		blendCounts.SetNumZeroed(paddedLength);
+		layerWeights.SetNumZeroed(paddedLength * layerCount);
+		patchRowWeights.SetNumZeroed(paddedLength);
+		noiseValues.SetNumZeroed(paddedLength);
+		heightRow.SetNumZeroed(paddedLength);
+	}
+
+	//narrower rows for tiles clipped by the component edge, the padded stride stays the same
+	FORCEINLINE void SetRowLength(int32 inRowLength)
+	{
+		check(inRowLength <= paddedLength);
+		rowLength = inRowLength;
+	}
+
+	FORCEINLINE void SetVertexBlend(int32 v, const int* patchIdxs, const float* weights, int32 count)
+	{
+		for (int32 k = 0; k < count; ++k)
+		{
+			blendPatchIdxs[v * LPatchBlend::MaxPatches + k] = patchIdxs[k];
+			blendWeights[v * LPatchBlend::MaxPatches + k] = weights[k];
+		}
+		blendCounts[v] = (uint8)count;
+	}
+
+	int32 rowLength;
+	int32 paddedLength;
+	int32 layerCount;
+	TArray<int32> blendPatchIdxs; //[v * MaxPatches + k]
+	TArray<float> blendWeights; //[v * MaxPatches + k]
+	TArray<uint8> blendCounts; //[v]
+	TArray<float> layerWeights; //[layer * paddedLength + v]
+	TArray<float> patchRowWeights; //blend weight of a single patch along the row
+	TArray<float> noiseValues;
+	TArray<int32, TInlineAllocator<16>> rowPatchIdxs; //unique patches touched by the row
+	TArray<float> heightRow; //interpolated source heights along the row, before noise
+	TArray<float> heightColumns; //source columns the row reads, already interpolated to the row's y
+};
+
+//per generation copy of the patch data touched in the per-vertex loop, indexed the same as LSharedTaskParams::patches
+//raw pointers are kept alive by LSharedTaskParams::patches for the duration of generation
+struct LCompiledPatch
+{
+public:
+	LPatch* patch;
+	//height settings copied when the tables are built, so tasks running while the patch editor is open never read the patch
+	float minHeight;
+	float maxHeight;
+	float heightSmoothFactor; //0 unless the patch height matches
+	TArray<LNoise*> noiseMaps;
+	TArray<LCompiledPaintWeight> paintWeights; //only paint weights whose texture is a current layer
+	TArray<uint8> uniformLayerWeights; //[layer], weights where this patch is the only one blended, empty if they depend on noise
+};
+
+//what foliage placement keeps of an applied component in streaming mode, instead of its full height and blend buffers
+//heights keep every HeightStep'th vertex, weights are only kept for foliage patches blended into the component
+struct LRetainedComponent
+{
+public:
+	static const int32 HeightStep = 2;
+
+	LRetainedComponent() : sizeVerts(0), heightSize(0) {}
+
+	//x, y in component vertices
+	float GetHeight(float x, float y) const;
+	float GetWeight(int32 patchIdx, int32 vertIdx) const;
+	SIZE_T GetAllocatedSize() const;
+
+	int32 sizeVerts; //ComponentSizeVerts
+	int32 heightSize; //retained heights per axis, the last one is always the component's edge
+	TArray<uint16> heights; //[y * heightSize + x]
+	TArray<int32> patchIdxs;
+	TArray<uint8> uniformWeights; //[slot], weight everywhere in the component when weights[slot] is empty
+	TArray<TArray<uint8>> weights; //[slot][vertex], full resolution
+};
+
+//where a tile kernel writes, vertex (x, y) of the generated rectangle goes to index y * stride + x of every buffer
+struct LTileTarget
+{
+public:
+	uint16* heights;
+	LPatchBlend* blends;
+	TArray<uint8*, TInlineAllocator<8>> layers;
+	int32 stride;
+};
+
+//vertices on the border between two neighboring components, shared by both
+struct LSeamSegment
+{
+public:
+	TArray<uint16> heights; //[v]
+	TArray<LPatchBlend> blends; //[v]
+	TArray<uint8> weights; //[layer * ComponentSizeVerts + v]
+};
+
+struct LSharedTaskParams;
+//generates a rectangle of global vertices, specialized once per run for the configuration being generated
+typedef void(*LTileKernel)(LSharedTaskParams& SP, const FIntRect& verts, const LTileTarget& target, LWeightRowScratch& weightScratch);
+
+//how vertices along one landscape axis sample the source map, indexed by global vertex
+//x and y are separable, so every vertex column and row is worked out once and shared by all components on it
+struct LSamplingAxis
+{
+	TArray<int32> cell0; //source cell before the vertex, clamped
+	TArray<int32> cell1; //source cell after the vertex, clamped
+	TArray<float> ease; //eased bilerp weight of cell1, for patch blending
+	TArray<float> noiseCoord; //coordinate the noise maps are sampled at
+	int32 vertCount;
+
+	//height interpolation, set by the ELHeightInterpolation policy
+	int32 heightTapCount; //source cells read per vertex along the axis, 2 or 4
+	TArray<int32> heightTaps; //[k * vertCount + v], clamped source cells, increasing with k
+	TArray<float> heightWeights; //[k * vertCount + v]
+
+	void Build(int32 uniqueVerts, int32 sourceSize, ELHeightInterpolation interpolation);
+};
+
+//copies of the noise maps a run samples, reseeded from the run's seed so every run or variant gets its own noise
+//maps shared between patches share their copy, pointers stay valid until the next Reset
+class LRunNoiseMaps
+{
+public:
+	LRunNoiseMaps() : seed(0) {}
+
+	void Reset(int32 inSeed);
+	//null for a null noise map
+	LNoise* Get(const LNoisePtr& noise);
+
+private:
+	int32 seed;
+	TArray<LNoisePtr> copies;
+	TMap<const LNoise*, LNoise*> copyLookup;
+};
+
+class LGenerationContext;
+
 struct LSharedTaskParams
 {
 public:
 	ALandscape* terrain;
+	LGenerationContext* context; //pooled buffers and scratch, outlives the run
 	int32 ComponentSizeVerts;
 	int layerCount;
 	int landscapeComponentCount;
 	int landscapeComponentCountSqrt;
 	int sourceSizeX;
 	int sourceSizeY;
-	TMap<LSymbolPtr, LPatchPtr> symbolPatchMap;
-	TArray<LPatchPtr> allUsedPatches;
-	FCriticalSection allUsedPatchesLock;
+	TArray<LPatchPtr> patches; //lSystem patches, followed by default patches for any unmatched symbols
+	TArray<LCompiledPatch> compiledPatches;
+	LRunNoiseMaps runNoiseMaps; //the noise maps compiledPatches sample, reseeded from seed
+	LSystemHandles handles;
+	TArray<LPatchId> symbolPatchIdxs; //[symbol id], every symbol resolves to a patch, unmatched ones to the default patch
+	TArray<int32> sourcePatchIdxs; //patch index for each source map cell, [y * sourceSizeX + x]
+	TArray<LPatchId> usedPatchIdxs; //patches referenced by any source map cell, found before the main loop
 	LSymbol2DMapPtr sourceLSymbolMap;
 	TArray<uint16> roughHeightmap;
 	TArray<uint16> smoothedHeightMap;
+	TArray<float> heightSamples; //smoothedHeightMap as floats for the height row kernels, padded by 4 so whole vectors can be read
+	LSamplingAxis samplingX; //uniqueVerts + 1 entries, shared by every component in a grid column
+	LSamplingAxis samplingY; //same for grid rows
 	float metersToU16;
 	uint16 zeroHeight;
 	LSystem* lSystem;
+	int32 seed;
+	FIntRect region; //components that may be regenerated, Max exclusive; the whole landscape unless a region was requested
+	int regionBorderFeather;
+	TArray<TArray<uint16>> regionBorderHeights; //landscape heights from before this run, only for dirty components within regionBorderFeather of a blended edge
 	TArray<ULandscapeLayerInfoObject*> layerInfos;
-	TArray<TArray<FColor>> heightMaps;
-	TArray<TArray<TArray<float>>> patchBlendData;
+	TArray<TArray<uint16>> heightMaps; //packed into the landscape's FColor format only when a component is applied
+	TArray<TArray<LPatchBlend>> patchBlendData; //[component][vertex]
 	TArray<TArray<TArray<uint8>>> weightMaps;
+	TArray<uint32> patchHashes; //per patch, covers everything the per-vertex loop reads from the patch
+	TArray<uint32> componentHashes;
+	TBitArray<> dirtyComponents; //components recomputed and applied this run, all others are left untouched
+	int dirtyComponentCount;
+	FThreadSafeBool bCancelled; //set from the game thread, workers stop at the next row
+	FThreadSafeCounter completedTileRows; //tile rows finished by the workers, for progress
+
+	//tile scheduling, workers claim square tiles of vertices from the components of componentOrder in order
+	TArray<int32> componentOrder; //dirty components, goes positive X for each +1, then positive Y for a row
+	int32 tileVerts; //vertices along each side of a tile
+	int32 tilesPerAxis;
+	int32 tilesPerComponent;
+	volatile int32 nextTile; //next unclaimed work item, seamSegments first and then component tiles, claimed with a compare exchange
+	FThreadSafeCounter admittedComponents; //tiles of componentOrder[0, admittedComponents) may be claimed, buffers for them exist
+	TArray<FThreadSafeCounter> componentTilesRemaining; //by position in componentOrder
+	TArray<int32> componentUniformPatchIdxs; //by position in componentOrder, the only patch a component reads or INDEX_NONE if mixed
+	LTileKernel tileKernel; //for tiles that are not uniform
+	TArray<LSeamSegment> verticalSeams; //[k * landscapeComponentCountSqrt + component row], between component columns k and k+1, empty unless next to a dirty component
+	TArray<LSeamSegment> horizontalSeams; //[k * landscapeComponentCountSqrt + component column], between component rows k and k+1
+	TArray<FIntPoint> seamSegments; //segments generated this run, X is 1 for vertical seams, Y is the seam index
+	FThreadSafeCounter seamsRemaining; //component tiles copy from the seams, so none is claimed until this reaches 0
+	FThreadSafeCounter activeWorkers;
 
-	//thread safe add unique
-	void AddUniqueToUsedPatches(LPatchPtr val)
+	//streaming mode, heightMaps and patchBlendData are released when a component is applied
+	bool bStreaming;
+	TArray<LRetainedComponent> retainedComponents; //[component], read by foliage placement instead of the full buffers
+};
+
+//free list of same purpose buffers, acquired and released whole so their allocations outlive any one run
+//buffers beyond maxFree are freed on release, so an idle pool only keeps what the last run's working window needed
+template<typename ElementType>
+class LBufferPool
+{
+public:
+	LBufferPool() : maxFree(0) {}
+
+	//contents are uninitialized
+	void Acquire(TArray<ElementType>& outBuffer, int32 num)
 	{
-		allUsedPatchesLock.Lock();
-		allUsedPatches.AddUnique(val);
-		allUsedPatchesLock.Unlock();
+		{
+			FScopeLock scopeLock(&lock);
+			if (freeBuffers.Num() > 0) outBuffer = freeBuffers.Pop(false);
+		}
+		outBuffer.SetNumUninitialized(num, false);
 	}
+
+	//leaves buffer empty
+	void Release(TArray<ElementType>& buffer)
+	{
+		if (buffer.Max() == 0) return;
+
+		FScopeLock scopeLock(&lock);
+		if (freeBuffers.Num() < maxFree)
+			freeBuffers.Add(MoveTemp(buffer));
+		else
+			buffer.Empty();
+	}
+
+	void SetMaxFree(int32 inMaxFree)
+	{
+		FScopeLock scopeLock(&lock);
+		maxFree = inMaxFree;
+		if (freeBuffers.Num() > maxFree) freeBuffers.SetNum(maxFree);
+	}
+
+	SIZE_T GetAllocatedSize()
+	{
+		FScopeLock scopeLock(&lock);
+		SIZE_T bytes = 0;
+		for (const TArray<ElementType>& buffer : freeBuffers)
+		{
+			bytes += buffer.GetAllocatedSize();
+		}
+		return bytes;
+	}
+
+private:
+	FCriticalSection lock;
+	TArray<TArray<ElementType>> freeBuffers;
+	int32 maxFree;
 };
 
+//memory reused by every generation in the editor session, so repeated runs while iterating on a design start warm
+//component buffers only change hands on the game thread, scratch and grids are taken by workers and foliage tasks
+class LGenerationContext
+{
+public:
+	LGenerationContext()
+	{
+		sourceHeights.SetMaxFree(1);
+	}
+
+	//sizes the component pools for a run's window of in flight components
+	void SetComponentWindow(int32 componentCount, int32 layerCount);
+
+	//worker scratch, handed back when the worker runs out of tiles
+	LWeightRowScratch* AcquireScratch(int32 rowLength, int32 layerCount);
+	void ReleaseScratch(LWeightRowScratch* scratch);
+
+	SIZE_T GetPooledBytes();
+
+	LBufferPool<uint16> componentHeights;
+	LBufferPool<LPatchBlend> componentBlends;
+	LBufferPool<uint8> layerWeights;
+	LBufferPool<uint16> sourceHeights; //rough heightmaps
+	LBufferPool<int32> foliageGrids; //poisson sampling acceleration grids
+
+private:
+	FCriticalSection scratchLock;
+	TArray<TUniquePtr<LWeightRowScratch>> freeScratch;
+};
+
+//state kept between generations on the same landscape
+class LGenerationCache
+{
+public:
+	void Reset()
+	{
+		terrain = nullptr;
+		componentHashes = TArray<uint32>();
+	}
+
+	TWeakObjectPtr<ALandscape> terrain;
+	TArray<uint32> componentHashes; //input hash of every component as last applied
+	LGenerationContext context; //not tied to the landscape, kept across Reset
+
+	//stamped as the ProceduralGuid of every foliage instance generation places, only those are ever removed again
+	//fixed rather than per session, so instances placed before the editor restarted are still recognized
+	static const FGuid FoliageGuid;
+};
+
+class LGenerationJob;
+
 class LTerrainGeneration
 {
 public:
-	static void GenerateTerrain(LSystem& lSystem, ALandscape* terrain);
+	//tile side in vertices, a tile's heights, blends and weights stay within L1/L2 while it is computed
+	static const int32 DefaultTileVerts = 32;
+
+	static TSharedPtr<LGenerationJob> GenerateTerrain(LSystem& lSystem, ALandscape* terrain, LGenerationCache& cache, const FIntRect* componentRegion = nullptr);
+	static bool PrepareGeneration(LSharedTaskParams& SP, LSystem& lSystem, ALandscape* terrain, const LGenerationCache& cache, const FIntRect* componentRegion);
+	static bool PrepareSourceTables(LSharedTaskParams& SP, LSystem& lSystem, ALandscape* terrain);
+	static FIntRect GetComponentRegionFromWorldBox(ALandscape* terrain, const FBox& worldBox);
+
+	static void BuildPatchTables(LSharedTaskParams& SP);
+	static void BuildSamplingAxes(LSharedTaskParams& SP);
+	static void BuildSamplingPlan(LSharedTaskParams& SP);
+	static void BuildRoughHeightmap(const LSharedTaskParams& SP, int32 seed, TArray<uint16>& outHeights);
+	static void SmoothHeightmap(const LSharedTaskParams& SP, const LGenSettings& settings, const TArray<uint16>& roughHeights, TArray<uint16>& outHeights);
+	static FIntRect GetComponentSourceWindow(const LSharedTaskParams& SP, int32 compIdx);
+	static FIntRect GetComponentHeightWindow(const LSharedTaskParams& SP, int32 compIdx);
+	static FIntRect GetTileVerts(const LSharedTaskParams& SP, int32 tileIdx);
+	static FIntRect GetTileInterior(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile);
+	static FIntRect GetGlobalVerts(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile);
+	static FIntRect GetTileSourceWindow(const LSharedTaskParams& SP, int32 compIdx, const FIntRect& tile);
+	static int32 GetUniformPatchIdx(const LSharedTaskParams& SP, const FIntRect& window);
+	static uint32 HashPatch(const LCompiledPatch& patch);
+	static void HashComponents(LSharedTaskParams& SP, const LGenerationCache& cache, bool bIncremental);
+	static int32 GetRegionBorderDistance(const LSharedTaskParams& SP, int32 gx, int32 gy);
+	static void CaptureRegionBorderHeights(LSharedTaskParams& SP);
+	static bool BlendRegionBorder(const LSharedTaskParams& SP, int32 compIdx, TArray<uint16>& heightData);
+	static void PackHeightmapData(const TArray<uint16>& heightData, TArray<FColor>& outColors);
+	static SIZE_T GetComponentBufferBytes(const LSharedTaskParams& SP);
+	static void RetainComponent(const LSharedTaskParams& SP, int32 compIdx, const TBitArray<>& foliagePatches, LRetainedComponent& outRetained);
 
 	static float SumNoiseMaps(TArray<LNoisePtr>& noiseMaps, float x, float y);
+	static float SumNoiseMaps(const TArray<LNoise*>& noiseMaps, float x, float y);
 	static float BilerpEase(float t);
-	static void GetWeightMapsAt(LSystem& lsystem, TArray<LPaintWeightPtr>& patchPaints, float x, float y, TArray<float>& outWeights, TArray<int>& idxsTouched);
+	static float InterpolateHeight(const LSharedTaskParams& SP, const TArray<uint16>& heights, int32 gx, int32 gy);
+	static void InterpolateHeightRow(const LSharedTaskParams& SP, LWeightRowScratch& scratch, int32 gx0, int32 count, int32 gy);
+	static void GetWeightMapRow(const LSharedTaskParams& SP, LWeightRowScratch& scratch, float scaledX0, float scaledXStep, float scaledY, uint8* const* outLayers, int32 rowOffset);
 };
\ No newline at end of file
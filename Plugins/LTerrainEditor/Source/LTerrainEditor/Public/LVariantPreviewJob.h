@@ -0,0 +1,92 @@
+#pragma once
+#include "LTerrainEditor.h"
+#include "LGenerationQueue.h"
+#include "LTerrainGeneration.h"
+
+#include "Async/AsyncWork.h"
+
+//low resolution heightmap of the whole landscape as generation would produce it for one seed
+struct LVariantPreview
+{
+public:
+	LVariantPreview() : seed(0), size(0), minHeight(0), maxHeight(0) {}
+
+	int32 seed;
+	int32 size; //pixels along each side, evenly spaced over the landscape's vertices
+	TArray<uint16> heights; //[y * size + x], landscape heights
+	uint16 minHeight;
+	uint16 maxHeight;
+};
+
+DECLARE_DELEGATE_OneParam(FOnVariantsPreviewed, const TArray<LVariantPreview>&)
+
+class FLVariantPreviewTask : public FNonAbandonableTask
+{
+	friend class FAutoDeleteAsyncTask<FLVariantPreviewTask>;
+
+public:
+	FLVariantPreviewTask(const LSharedTaskParams& SP, const LGenSettings& settings, const TArray<TArray<LNoise*>>& patchNoiseMaps, LVariantPreview& outPreview, const FThreadSafeBool& bCancelled, FThreadSafeCounter& completedVariants) :
+		SP(SP),
+		settings(settings),
+		patchNoiseMaps(patchNoiseMaps),
+		outPreview(outPreview),
+		bCancelled(bCancelled),
+		completedVariants(completedVariants)
+	{}
+
+protected:
+	void DoWork();
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FLVariantPreviewTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+protected:
+	const LSharedTaskParams& SP;
+	const LGenSettings& settings;
+	const TArray<TArray<LNoise*>>& patchNoiseMaps;
+	LVariantPreview& outPreview;
+	const FThreadSafeBool& bCancelled;
+	FThreadSafeCounter& completedVariants;
+};
+
+//previews of the same LSystem on one landscape for several seeds, one task per seed on the queue's pool
+//patch tables and sampling axes do not depend on the seed and are built once, each variant only redoes heights and noise
+//tasks read patch settings only through the copies in SP.compiledPatches, never the editor's patches
+class LVariantPreviewJob : public LQueuedJob
+{
+public:
+	static const int32 PreviewSize = 128;
+
+	LVariantPreviewJob(LSystem& lSystem, ALandscape* terrain, const TArray<int32>& seeds, FOnVariantsPreviewed onPreviewed);
+	virtual ~LVariantPreviewJob();
+
+	virtual void Start(FQueuedThreadPool* pool, int32 poolThreadCount) override;
+	virtual bool Tick() override;
+	virtual void Cancel() override { bCancelled = true; }
+	virtual void CancelAndWait() override;
+	//only the latest set of previews is shown
+	virtual bool Supersedes(const LQueuedJob& older) const override { return older.type == ELJobType::VariantPreview; }
+	virtual bool IsRunning() const override { return bRunning; }
+	virtual float GetProgress() const override;
+	virtual FText GetStatusText() const override;
+
+	static void BuildPreview(const LSharedTaskParams& SP, const LGenSettings& settings, const TArray<TArray<LNoise*>>& patchNoiseMaps, const FThreadSafeBool& bCancelled, LVariantPreview& preview);
+
+private:
+	LSystem& lSystem;
+	TWeakObjectPtr<ALandscape> terrainPtr;
+	TArray<int32> seeds;
+	FOnVariantsPreviewed onPreviewed;
+
+	LSharedTaskParams SP; //seed independent tables shared by every variant
+	LGenSettings settings; //as they were when the job started
+	TArray<LRunNoiseMaps> variantNoiseMaps; //[variant]
+	TArray<TArray<TArray<LNoise*>>> variantPatchNoiseMaps; //[variant][patch], height noise of the patches on the source map
+	TArray<LVariantPreview> previews;
+	FThreadSafeCounter completedVariants;
+	FThreadSafeBool bCancelled;
+	bool bRunning;
+	double startTime;
+};